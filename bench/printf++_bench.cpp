@@ -0,0 +1,184 @@
+// license at eof
+// printf++ benchmark, ns per call and bytes per second of each specifier family,
+// through snprintf(), fctprintf() and printf(), against the libc snprintf() and std::to_chars
+// the results are written to stdout as JSON, printf() itself writes to /dev/null
+//   printf++_bench [milliseconds per measurement, 100 by default]
+// build e.g.
+//   g++ -std=c++17 -O2 bench/printf++_bench.cpp -o printf++_bench -ldl
+#include "../printf++.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <unistd.h>
+
+namespace {
+	constexpr inline auto values_size = 1024U;    // argument values, cycled through
+	constexpr inline auto repeats = 3U;           // the best of these is taken
+
+	int ints[values_size];
+	unsigned int uints[values_size];
+	double doubles[values_size];
+	const char* strings[values_size];
+	void* pointers[values_size];
+
+	char buffer[256];
+	double milliseconds = 100.0;
+	// the snprintf() of this program is the printf++ one, extern "C", the libc one is looked up after it
+	int(*libc_snprintf)(char* buffer, size_t count, const char* format, ...) = nullptr;
+	FILE* json = nullptr;
+	bool first_result = true;
+
+	// fctprintf() output, counted only
+	size_t fct_count = 0U;
+	void _out_count(char character, void* arg)
+	{
+		(void)character; (void)arg;
+		fct_count++;
+	}
+
+
+	void make_values()
+	{
+		static const char* words[] = { "", "a", "printf", "GET /index.html", "a somewhat longer string argument", "0123456789abcdef0123456789abcdef0123456789" };
+		uint64_t x = 0x9E3779B97F4A7C15ULL;
+		for (unsigned int i = 0U; i < values_size; ++i) {
+			x ^= x << 13U; x ^= x >> 7U; x ^= x << 17U;
+			// all lengths, not only the longest
+			ints[i] = (int)(x >> (33U + (i % 31U))) * (i & 1U ? -1 : 1);
+			uints[i] = (unsigned int)(x >> (32U + (i % 32U)));
+			doubles[i] = (double)(int64_t)(x >> (20U + (i % 40U))) / 1024.0 * (i & 2U ? -1.0 : 1.0);
+			strings[i] = words[i % (sizeof(words) / sizeof(words[0]))];
+			pointers[i] = (void*)(uintptr_t)(x >> (i % 48U));
+		}
+	}
+
+
+	// times call(i) over milliseconds, the best of repeats
+	template <typename Call>
+	void measure(const char* family, const char* format, const char* impl, Call call)
+	{
+		using clock = std::chrono::steady_clock;
+		// calibrate the number of calls
+		size_t calls = 1024U;
+		for (;;) {
+			const clock::time_point start = clock::now();
+			for (size_t i = 0U; i < calls; ++i) {
+				call(i);
+			}
+			if (std::chrono::duration<double, std::milli>(clock::now() - start).count() > milliseconds / 8.0) {
+				break;
+			}
+			calls *= 2U;
+		}
+
+		double best = 0.0;
+		size_t bytes = 0U;
+		for (unsigned int r = 0U; r < repeats; ++r) {
+			size_t total = 0U;
+			const clock::time_point start = clock::now();
+			for (size_t i = 0U; i < calls; ++i) {
+				total += (size_t)call(i);
+			}
+			const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			if (!r || (ns < best)) {
+				best = ns;
+				bytes = total;
+			}
+		}
+
+		std::fprintf(json, "%s\n    { \"family\": \"%s\", \"format\": \"%s\", \"impl\": \"%s\", \"calls\": %zu, \"ns_per_call\": %.2f, \"bytes_per_sec\": %.0f }",
+			first_result ? "" : ",", family, format, impl, calls, best / (double)calls, (double)bytes / best * 1e9);
+		first_result = false;
+	}
+
+
+	// std::to_chars version of a case, when there is one
+	enum to_chars_type { TO_CHARS_NONE, TO_CHARS_DEC, TO_CHARS_HEX, TO_CHARS_FIXED };
+
+
+	template <typename T>
+	void bench(const char* family, const char* format, const T* values, to_chars_type to_chars = TO_CHARS_NONE, int precision = 6)
+	{
+		const size_t mask = values_size - 1U;
+		measure(family, format, "printf++ snprintf", [&](size_t i) {
+			return mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), format, values[i & mask]);
+		});
+		measure(family, format, "printf++ fctprintf", [&](size_t i) {
+			return mpaland_dbjdbj::fctprintf(_out_count, nullptr, format, values[i & mask]);
+		});
+		measure(family, format, "printf++ printf", [&](size_t i) {
+			return mpaland_dbjdbj::printf(format, values[i & mask]);
+		});
+		measure(family, format, "libc snprintf", [&](size_t i) {
+			return libc_snprintf(buffer, sizeof(buffer), format, values[i & mask]);
+		});
+		if constexpr (std::is_arithmetic_v<T>) {
+			if (to_chars != TO_CHARS_NONE) {
+				measure(family, format, "std::to_chars", [&](size_t i) {
+					std::to_chars_result result;
+					if constexpr (std::is_floating_point_v<T>) {
+						result = std::to_chars(buffer, buffer + sizeof(buffer), values[i & mask], std::chars_format::fixed, precision);
+					}
+					else {
+						result = std::to_chars(buffer, buffer + sizeof(buffer), values[i & mask], to_chars == TO_CHARS_HEX ? 16 : 10);
+					}
+					return (int)(result.ptr - buffer);
+				});
+			}
+		}
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) {
+		milliseconds = std::atof(argv[1]);
+	}
+	// the JSON goes to the standard output, printf() to /dev/null
+	json = fdopen(dup(1), "w");
+	if (!json || !std::freopen("/dev/null", "w", stdout)) {
+		std::fprintf(stderr, "printf++_bench: cannot redirect the standard output\n");
+		return 1;
+	}
+	libc_snprintf = (int(*)(char*, size_t, const char*, ...))dlsym(RTLD_NEXT, "snprintf");
+	if (!libc_snprintf || (libc_snprintf == static_cast<int(*)(char*, size_t, const char*, ...)>(&mpaland_dbjdbj::snprintf))) {
+		std::fprintf(stderr, "printf++_bench: cannot find the libc snprintf()\n");
+		return 1;
+	}
+	make_values();
+
+	std::fprintf(json, "{\n  \"benchmark\": \"printf++\",\n  \"compiler\": \"%s\",\n  \"milliseconds\": %.0f,\n  \"results\": [", __VERSION__, milliseconds);
+	bench("%d", "%d", ints, TO_CHARS_DEC);
+	bench("%d", "%10d", ints);
+	bench("%d", "%-12d|", ints);
+	bench("%d", "%+.8d", ints);
+	bench("%x", "%x", uints, TO_CHARS_HEX);
+	bench("%x", "%08x", uints);
+	bench("%x", "%#X", uints);
+	bench("%s", "%s", strings);
+	bench("%s", "%20s", strings);
+	bench("%s", "%.10s", strings);
+	bench("%f", "%f", doubles, TO_CHARS_FIXED, 6);
+	bench("%f", "%.2f", doubles, TO_CHARS_FIXED, 2);
+	bench("%f", "%12.4f", doubles);
+	bench("%e", "%e", doubles);
+	bench("%g", "%g", doubles);
+	bench("%p", "%p", pointers);
+	std::fprintf(json, "\n  ]\n}\n");
+	std::fclose(json);
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// \author (c) C VERSION -- Marco Paland (info@paland.com)
+//             2014-2018, PALANDesign Hannover, Germany
+//         (c) CPP HEADER ONLY VERSION -- Dusan B. Jovanovic ( dbj@dbj.org )
+//             2018, dbj.systems, London, UK
+//
+// \license The MIT License (MIT)
+///////////////////////////////////////////////////////////////////////////////
@@ -8,8 +8,82 @@
 #error C++17 REQUIRED
 #endif
 
+#include <atomic> 
+#include <cmath> 
 #include <cstdint> 
 #include <cstdarg> 
+#include <cstddef> 
+#include <cstdio> 
+#include <cstdlib> 
+#include <cstring> 
+#include <string> 
+#include <string_view> 
+#include <type_traits> 
+#include <vector> 
+
+// the format string is scanned for literal runs with SSE2 or AVX2 when available
+// define PRINTF_DISABLE_SIMD to use the portable SWAR scan instead
+#if !defined(PRINTF_DISABLE_SIMD)
+#if defined(__AVX2__)
+#define PRINTF_SUPPORT_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define PRINTF_SUPPORT_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// printf() hands its output to stdio in blocks, unless PRINTF_USER_DEFINED_PUTCHAR is used
+// define PRINTF_STDOUT_USE_WRITE to bypass stdio and write(2) to the standard output directly
+// define PRINTF_STDOUT_LINE_FLUSH to hand the output over at each new line, too
+#if defined(PRINTF_STDOUT_USE_WRITE) || defined(PRINTF_SUPPORT_LOG_RING)
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+// define PRINTF_SUPPORT_LOG_RING for log_printf(), formatting into a lock-free ring
+// of slots, written out to a file descriptor by a drain thread
+#if defined(PRINTF_SUPPORT_LOG_RING)
+#include <chrono> 
+#include <condition_variable> 
+#include <mutex> 
+#include <new> 
+#include <thread> 
+#endif
+
+// define PRINTF_SUPPORT_FORMAT_ARENA for arena_printf(), formatting into a bump allocator
+// over the caller's buffer and a std::pmr::memory_resource
+#if defined(PRINTF_SUPPORT_FORMAT_ARENA)
+#include <memory_resource> 
+#endif
+
+// define PRINTF_SUPPORT_INSTRUMENTATION to count the conversions, by specifier and flags,
+// in counters of each thread, added up by format_stats()
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+#include <mutex> 
+#endif
+
+// the literal scan reads whole aligned words, which may extend past
+// the terminating 0 but never past the page holding it
+#if defined(__SANITIZE_ADDRESS__) && defined(_MSC_VER)
+#define PRINTF_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#elif defined(__SANITIZE_ADDRESS__)
+#define PRINTF_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define PRINTF_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#endif
+#endif
+#if !defined(PRINTF_NO_SANITIZE_ADDRESS)
+#define PRINTF_NO_SANITIZE_ADDRESS
+#endif
 
 // #ifdef PRINTF_DECLARE_EXTERN_C
 // I personlay think 'extern "C"' here can do no harm
@@ -46,14 +120,69 @@ namespace inner {
 	// 32 byte is a good default
 	constexpr inline const auto PRINTF_NTOA_BUFFER_SIZE = 32U;
 
-	// ftoa conversion buffer size, this must be big enough to hold
-	// one converted float number including padded zeros (dynamically created on stack)
-	// 32 byte is a good default
-	constexpr inline const auto PRINTF_FTOA_BUFFER_SIZE = 32U;
+	// padding buffer size, width padding is written out in blocks of this size
+	constexpr inline const auto PRINTF_PAD_BUFFER_SIZE = 32U;
+
+	// format_to() and asprintf() staging buffer size, the output is kept on the stack
+	// up to this size, and only then moved to the growing storage
+	constexpr inline const auto PRINTF_GROW_STAGE_SIZE = 256U;
+
+	// size of the blocks a format arena takes from its memory resource, unless a string needs more
+	constexpr inline const auto PRINTF_ARENA_BLOCK_SIZE = 4096U;
+
+	// fctprintf_block() staging buffer size (on the stack), the output is handed
+	// to the user function in blocks of up to this size
+	constexpr inline const auto PRINTF_FCT_BUFFER_SIZE = 128U;
+
+	// log ring slot size, log_printf() messages longer than this (with the terminating 0) are cut
+	constexpr inline const auto PRINTF_LOG_SLOT_SIZE = 256U;
+
+	// binary log string length of a null char pointer, longer than any string of a slot
+	constexpr inline const uint16_t PRINTF_LOG_NULL_STRING = 0xFFFFU;
+
+	// log ring write size, the drain writes the messages out in blocks of up to this size
+	constexpr inline const auto PRINTF_LOG_WRITE_SIZE = 16384U;
+
+	// most arguments of a deferred log message, log_defer()
+	constexpr inline const auto PRINTF_LOG_DEFER_ARGS = 16U;
+
+	// binary log format dictionary size, the number of formats given an id, must be a power of 2
+	// (the messages of the formats past it are written as text)
+	constexpr inline const auto PRINTF_LOG_FORMATS = 1024U;
+
+	// longest sleep of an idle drain thread, in milliseconds, in case a wake up was missed
+	constexpr inline const auto PRINTF_LOG_IDLE_WAIT = 100U;
+
+	// printf() staging buffer size, the output of printf() is handed to stdio
+	// in blocks of this size (thread local, not on the stack)
+	constexpr inline const auto PRINTF_STDOUT_BUFFER_SIZE = 512U;
+
+	// format cache size, the number of formats kept compiled, must be a power of 2
+	constexpr inline const auto PRINTF_FORMAT_CACHE_SIZE = 64U;
+
+	// formats with more than this number of operations (conversions + 1) are not cached
+	constexpr inline const auto PRINTF_FORMAT_CACHE_OPS = 16U;
+
+	// instrumentation counters, by specifier character and by flag combination
+	constexpr inline const auto PRINTF_STATS_SPECIFIERS = 128U;
+	constexpr inline const auto PRINTF_STATS_FLAGS = 128U;
+
+	// digits buffer of the exact float conversion, room for the 767 significant digits a double
+	// can have, and the 9 digit chunks they are converted in
+	constexpr inline const auto PRINTF_DTOA_BUFFER_SIZE = 784U;
+
+	// digits after the point of the exact %f conversion, a double has up to 1074 of them, the rest is 0
+	constexpr inline const auto PRINTF_DTOA_FRACTION_MAX = 1088U;
+
+	// multiword integer size of the exact float conversion, in 32 bit words, enough for any double
+	constexpr inline const auto PRINTF_BIG_WORDS = 36U;
 
 	// define this to support floating point (%f)
 #define PRINTF_SUPPORT_FLOAT
 
+// define this to support exponential floating point notation (%e/%g)
+#define PRINTF_SUPPORT_EXPONENTIAL
+
 // define this to support long long types (%llu or %p)
 #define PRINTF_SUPPORT_LONG_LONG
 
@@ -77,12 +206,63 @@ namespace inner {
 	constexpr inline const auto FLAGS_LONG_LONG = (1U << 9U);
 	constexpr inline const auto FLAGS_PRECISION = (1U << 10U);
 	constexpr inline const auto FLAGS_WIDTH = (1U << 11U);
+	constexpr inline const auto FLAGS_WIDTH_ARG = (1U << 12U);
+	constexpr inline const auto FLAGS_PRECISION_ARG = (1U << 13U);
+	constexpr inline const auto FLAGS_ADAPT_EXP = (1U << 14U);
 
 
 	// output function type
 	typedef void(*out_fct_type)(char character, void* buffer, size_t idx, size_t maxlen);
 
 
+	// block output function type
+	// receives a run of 'len' characters, the first one to be placed at 'idx'
+	typedef void(*out_block_fct_type)(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen);
+
+
+	// conversion specification %[flags][width][.precision][length]specifier
+	// width and precision given as '*' are marked by FLAGS_WIDTH_ARG and FLAGS_PRECISION_ARG
+	typedef struct {
+		unsigned int flags;
+		unsigned int width;
+		unsigned int precision;
+		char specifier;
+	} spec_type;
+
+
+	// compiled format operation
+	// a literal run of the format string, followed by a conversion
+	// the last operation of a compiled format has no conversion (specifier 0)
+	typedef struct {
+		unsigned int offset;
+		unsigned int length;
+		spec_type spec;
+	} format_op_type;
+
+
+	// argument types of the type safe format()
+	constexpr inline const auto ARG_SIGNED = 1U;
+	constexpr inline const auto ARG_UNSIGNED = 2U;
+	constexpr inline const auto ARG_DOUBLE = 3U;
+	constexpr inline const auto ARG_STRING = 4U;
+	constexpr inline const auto ARG_POINTER = 5U;
+
+
+	// argument of the type safe format(), as it was given, without the varargs promotions
+	typedef struct {
+		unsigned int type;
+		unsigned int size;    // of the integer types, in bytes
+		union {
+			long long i;
+			unsigned long long u;
+			double d;
+			const char* s;
+			const void* p;
+		};
+		size_t length;        // of the strings, (size_t)-1 when 0 terminated
+	} arg_type;
+
+
 	// wrapper (used as buffer) for output function type
 	typedef struct {
 		void(*fct)(char character, void* arg);
@@ -90,6 +270,14 @@ namespace inner {
 	} out_fct_wrap_type;
 
 
+	// wrapper (used as buffer) adapting the character output function type
+	// to the block output function type
+	typedef struct {
+		out_fct_type fct;
+		void* buffer;
+	} out_block_wrap_type;
+
+
 	// internal buffer output
 	PRINTF_EXTERN_C inline void _out_buffer(char character, void* buffer, size_t idx, size_t maxlen)
 	{
@@ -99,6 +287,18 @@ namespace inner {
 	}
 
 
+	// internal buffer block output
+	PRINTF_EXTERN_C inline void _out_buffer_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		if (idx < maxlen) {
+			if (len > maxlen - idx) {
+				len = maxlen - idx;
+			}
+			std::memcpy((char*)buffer + idx, data, len);
+		}
+	}
+
+
 	// internal null output
 	PRINTF_EXTERN_C inline void _out_null(char character, void* buffer, size_t idx, size_t maxlen)
 	{
@@ -106,6 +306,48 @@ namespace inner {
 	}
 
 
+	// internal null block output
+	PRINTF_EXTERN_C inline void _out_null_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)data; (void)len; (void)buffer; (void)idx; (void)maxlen;
+	}
+
+
+	// block outputs known at compile time, the engine is instantiated for each of them, with
+	// its output inlined; the other outputs are called through an out_block_fct_type pointer
+	typedef struct out_buffer_sink_type {
+		void operator()(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen) const
+		{
+			_out_buffer_block(data, len, buffer, idx, maxlen);
+		}
+	} out_buffer_sink_type;
+
+
+	typedef struct out_null_sink_type {
+		void operator()(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen) const
+		{
+			(void)data; (void)len; (void)buffer; (void)idx; (void)maxlen;
+		}
+	} out_null_sink_type;
+
+
+	// internal check for the null output, only measuring
+	template <typename O>
+	inline bool _is_null_sink(O out)
+	{
+		if constexpr (std::is_same_v<O, out_null_sink_type>) {
+			return true;
+		}
+		else if constexpr (std::is_same_v<O, out_block_fct_type>) {
+			return out == _out_null_block;
+		}
+		else {
+			(void)out;
+			return false;
+		}
+	}
+
+
 	// internal _putchar wrapper
 	PRINTF_EXTERN_C inline void _out_char(char character, void* buffer, size_t idx, size_t maxlen)
 	{
@@ -116,6 +358,132 @@ namespace inner {
 	}
 
 
+	// internal _putchar block wrapper
+	PRINTF_EXTERN_C inline void _out_char_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)buffer; (void)idx; (void)maxlen;
+		for (size_t i = 0U; i < len; i++) {
+			if (data[i]) {
+				_putchar(data[i]);
+			}
+		}
+	}
+
+
+#if !defined(PRINTF_USER_DEFINED_PUTCHAR)
+	// printf() staging buffer, one per thread
+	typedef struct {
+		char data[PRINTF_STDOUT_BUFFER_SIZE];
+		size_t len;
+	} out_stdout_type;
+
+
+	// internal hand over of a block to the standard output
+	PRINTF_EXTERN_C inline void _stdout_write(const char* data, size_t len)
+	{
+#if defined(PRINTF_STDOUT_USE_WRITE)
+		while (len) {
+#if defined(_WIN32)
+			const int written = _write(1, data, (unsigned int)len);
+#else
+			const ssize_t written = ::write(1, data, len);
+#endif
+			if (written <= 0) {
+				break;
+			}
+			data += written;
+			len -= (size_t)written;
+		}
+#else
+		std::fwrite(data, 1U, len, stdout);
+#endif
+	}
+
+
+	// internal hand over of the staged output
+	PRINTF_EXTERN_C inline void _stdout_flush(out_stdout_type* stage)
+	{
+		if (stage->len) {
+			_stdout_write(stage->data, stage->len);
+			stage->len = 0U;
+		}
+	}
+
+
+	// internal staging buffer of this thread
+	PRINTF_EXTERN_C inline out_stdout_type* _stdout_buffer()
+	{
+		static thread_local out_stdout_type stage{};
+		return &stage;
+	}
+
+
+	// internal staging of a block, on its way to the standard output
+	PRINTF_EXTERN_C inline void _stdout_stage(out_stdout_type* stage, const char* data, size_t len)
+	{
+		// blocks bigger than the staging buffer go out directly
+		if (len >= PRINTF_STDOUT_BUFFER_SIZE) {
+			_stdout_flush(stage);
+			_stdout_write(data, len);
+			return;
+		}
+		while (len) {
+			size_t n = PRINTF_STDOUT_BUFFER_SIZE - stage->len;
+			if (n > len) {
+				n = len;
+			}
+			std::memcpy(stage->data + stage->len, data, n);
+			stage->len += n;
+			data += n;
+			len -= n;
+			if (stage->len == PRINTF_STDOUT_BUFFER_SIZE) {
+				_stdout_flush(stage);
+			}
+		}
+	}
+
+
+	// internal staged standard output
+	PRINTF_EXTERN_C inline void _out_stdout_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)idx; (void)maxlen;
+		// buffer is the staging buffer
+		out_stdout_type* stage = (out_stdout_type*)buffer;
+		while (len) {
+			// like _out_char, 0 characters are not written out
+			const char* end = (const char*)std::memchr(data, 0, len);
+			size_t run = end ? (size_t)(end - data) : len;
+#if defined(PRINTF_STDOUT_LINE_FLUSH)
+			const char* eol = (const char*)std::memchr(data, '\n', run);
+			if (eol) {
+				run = (size_t)(eol - data) + 1U;
+			}
+#endif
+			_stdout_stage(stage, data, run);
+#if defined(PRINTF_STDOUT_LINE_FLUSH)
+			if (eol) {
+				_stdout_flush(stage);
+			}
+			else
+#endif
+			if (end) {
+				run++;
+			}
+			data += run;
+			len -= run;
+		}
+	}
+
+
+	typedef struct out_stdout_sink_type {
+		void operator()(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen) const
+		{
+			_out_stdout_block(data, len, buffer, idx, maxlen);
+		}
+	} out_stdout_sink_type;
+#endif  // !PRINTF_USER_DEFINED_PUTCHAR
+
+
 	// internal output function wrapper
 	PRINTF_EXTERN_C inline void _out_fct(char character, void* buffer, size_t idx, size_t maxlen)
 	{
@@ -125,6 +493,87 @@ namespace inner {
 	}
 
 
+	// internal output function block wrapper
+	PRINTF_EXTERN_C inline void _out_fct_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)idx; (void)maxlen;
+		// buffer is the output fct pointer
+		const out_fct_wrap_type* wrap = (const out_fct_wrap_type*)buffer;
+		for (size_t i = 0U; i < len; i++) {
+			wrap->fct(data[i], wrap->arg);
+		}
+	}
+
+
+	// staged block output to a user function
+	typedef struct {
+		void(*fct)(const char* data, size_t len, void* arg);
+		void* arg;
+		size_t len;
+		char data[PRINTF_FCT_BUFFER_SIZE];
+	} out_fct_stage_type;
+
+
+	// internal hand over of the staged output to the user function
+	PRINTF_EXTERN_C inline void _fct_stage_flush(out_fct_stage_type* stage)
+	{
+		if (stage->len) {
+			stage->fct(stage->data, stage->len, stage->arg);
+			stage->len = 0U;
+		}
+	}
+
+
+	// internal staged block output to a user function, one call per full stage
+	PRINTF_EXTERN_C inline void _out_fct_stage_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)idx; (void)maxlen;
+		// buffer is the staging buffer
+		out_fct_stage_type* stage = (out_fct_stage_type*)buffer;
+		if (stage->len + len > PRINTF_FCT_BUFFER_SIZE) {
+			_fct_stage_flush(stage);
+			if (len >= PRINTF_FCT_BUFFER_SIZE) {
+				// too long to stage, handed over as it is
+				stage->fct(data, len, stage->arg);
+				return;
+			}
+		}
+		std::memcpy(stage->data + stage->len, data, len);
+		stage->len += len;
+	}
+
+
+	// adapter feeding a block to a character output function, one by one
+	PRINTF_EXTERN_C inline void _out_block_wrap(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		// buffer is the wrapped output fct and its buffer
+		const out_block_wrap_type* wrap = (const out_block_wrap_type*)buffer;
+		for (size_t i = 0U; i < len; i++) {
+			wrap->fct(data[i], wrap->buffer, idx + i, maxlen);
+		}
+	}
+
+
+	// internal output of 'count' copies of the (padding) character
+	// \return The index after the last character written
+	template <typename O>
+	inline size_t _out_fill(O out, char* buffer, size_t idx, size_t maxlen, char character, size_t count)
+	{
+		if (_is_null_sink(out)) {
+			return idx + count;
+		}
+		char pad[PRINTF_PAD_BUFFER_SIZE];
+		std::memset(pad, character, count < PRINTF_PAD_BUFFER_SIZE ? count : PRINTF_PAD_BUFFER_SIZE);
+		while (count) {
+			const size_t len = count < PRINTF_PAD_BUFFER_SIZE ? count : PRINTF_PAD_BUFFER_SIZE;
+			out(pad, len, buffer, idx, maxlen);
+			idx += len;
+			count -= len;
+		}
+		return idx;
+	}
+
+
 	// internal strlen
 	// \return The length of the string (excluding the terminating 0)
 	PRINTF_EXTERN_C inline unsigned int _strlen(const char* str)
@@ -135,16 +584,148 @@ namespace inner {
 	}
 
 
+	// internal secure strlen
+	// \return The length of the string (excluding the terminating 0) limited by 'maxsize'
+	PRINTF_EXTERN_C inline unsigned int _strnlen_s(const char* str, size_t maxsize)
+	{
+		const char* s;
+		for (s = str; *s && maxsize--; ++s);
+		return (unsigned int)(s - str);
+	}
+
+
+	// internal count of trailing zero bits, 'value' must not be 0
+	PRINTF_EXTERN_C inline unsigned int _ctz(unsigned int value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return (unsigned int)index;
+#else
+		return (unsigned int)__builtin_ctz(value);
+#endif
+	}
+
+
+	// internal count of leading zero bits, 'value' must not be 0
+	PRINTF_EXTERN_C inline unsigned int _clz(unsigned long long value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return 63U - (unsigned int)index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (value >> 32U) {
+			_BitScanReverse(&index, (unsigned long)(value >> 32U));
+			return 31U - (unsigned int)index;
+		}
+		_BitScanReverse(&index, (unsigned long)value);
+		return 63U - (unsigned int)index;
+#else
+		return (unsigned int)__builtin_clzll(value);
+#endif
+	}
+
+
+	// decimal digits, two at a time
+	constexpr inline const char digit_pairs[] =
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+
+	// powers of 10 which fit into 64 bits
+	constexpr inline const unsigned long long pow10_table[] = {
+		1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+		10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+		1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+		10000000000000000000ULL
+	};
+
+
+	// internal scan for the end of a literal run
+	// \return Pointer to the first '%' or the terminating 0 of the format string
+	PRINTF_EXTERN_C PRINTF_NO_SANITIZE_ADDRESS inline const char* _find_specifier(const char* format)
+	{
+#if defined(PRINTF_SUPPORT_AVX2)
+		// start at the aligned block holding format, and ignore the bytes before it
+		const __m256i percent = _mm256_set1_epi8('%');
+		const __m256i zero = _mm256_setzero_si256();
+		const unsigned int skip = (unsigned int)((uintptr_t)format & 31U);
+		const char* p = format - skip;
+		__m256i block = _mm256_load_si256((const __m256i*)p);
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, percent), _mm256_cmpeq_epi8(block, zero))) >> skip;
+		if (mask) {
+			return format + _ctz(mask);
+		}
+		for (;;) {
+			p += 32;
+			block = _mm256_load_si256((const __m256i*)p);
+			mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, percent), _mm256_cmpeq_epi8(block, zero)));
+			if (mask) {
+				return p + _ctz(mask);
+			}
+		}
+#elif defined(PRINTF_SUPPORT_SSE2)
+		// start at the aligned block holding format, and ignore the bytes before it
+		const __m128i percent = _mm_set1_epi8('%');
+		const __m128i zero = _mm_setzero_si128();
+		const unsigned int skip = (unsigned int)((uintptr_t)format & 15U);
+		const char* p = format - skip;
+		__m128i block = _mm_load_si128((const __m128i*)p);
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, percent), _mm_cmpeq_epi8(block, zero))) >> skip;
+		if (mask) {
+			return format + _ctz(mask);
+		}
+		for (;;) {
+			p += 16;
+			block = _mm_load_si128((const __m128i*)p);
+			mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, percent), _mm_cmpeq_epi8(block, zero)));
+			if (mask) {
+				return p + _ctz(mask);
+			}
+		}
+#else
+		// SWAR: test 8 characters at once for a 0 or a '%' byte
+		const uint64_t ones = 0x0101010101010101ULL;
+		const uint64_t highs = 0x8080808080808080ULL;
+		const uint64_t percents = ones * (uint64_t)'%';
+		while ((uintptr_t)format & 7U) {
+			if (!*format || (*format == '%')) {
+				return format;
+			}
+			format++;
+		}
+		for (;;) {
+			uint64_t word;
+			std::memcpy(&word, format, sizeof(word));
+			const uint64_t pct = word ^ percents;
+			if (((word - ones) & ~word & highs) | ((pct - ones) & ~pct & highs)) {
+				break;
+			}
+			format += sizeof(word);
+		}
+		while (*format && (*format != '%')) {
+			format++;
+		}
+		return format;
+#endif
+	}
+
+
 	// internal test if char is a digit (0-9)
 	// \return true if char is a digit
-	PRINTF_EXTERN_C inline bool _is_digit(char ch)
+	PRINTF_EXTERN_C constexpr inline bool _is_digit(char ch)
 	{
 		return (ch >= '0') && (ch <= '9');
 	}
 
 
 	// internal ASCII string to unsigned int conversion
-	PRINTF_EXTERN_C inline unsigned int _atoi(const char** str)
+	PRINTF_EXTERN_C constexpr inline unsigned int _atoi(const char** str)
 	{
 		unsigned int i = 0U;
 		while (_is_digit(**str)) {
@@ -155,16 +736,20 @@ namespace inner {
 
 
 	// internal itoa format
-	PRINTF_EXTERN_C  inline size_t _ntoa_format(out_fct_type out, char* buffer, size_t idx, size_t maxlen, char* buf, size_t len, bool negative, unsigned int base, unsigned int prec, unsigned int width, unsigned int flags)
+	// the digits are the last len characters of the conversion buffer buf, in their final order
+	// the zeros, the prefix and the sign are put in front of them
+	template <typename O>
+	inline size_t _ntoa_format(O out, char* buffer, size_t idx, size_t maxlen, char* buf, size_t len, bool negative, unsigned int base, unsigned int prec, unsigned int width, unsigned int flags)
 	{
 		const size_t start_idx = idx;
+		char* const end = buf + PRINTF_NTOA_BUFFER_SIZE;
 
 		// pad leading zeros
 		while (!(flags & FLAGS_LEFT) && (len < prec) && (len < PRINTF_NTOA_BUFFER_SIZE)) {
-			buf[len++] = '0';
+			*(end - ++len) = '0';
 		}
 		while (!(flags & FLAGS_LEFT) && (flags & FLAGS_ZEROPAD) && (len < width) && (len < PRINTF_NTOA_BUFFER_SIZE)) {
-			buf[len++] = '0';
+			*(end - ++len) = '0';
 		}
 
 		// handle hash
@@ -176,68 +761,188 @@ namespace inner {
 				}
 			}
 			if ((base == 16U) && !(flags & FLAGS_UPPERCASE) && (len < PRINTF_NTOA_BUFFER_SIZE)) {
-				buf[len++] = 'x';
+				*(end - ++len) = 'x';
 			}
 			if ((base == 16U) && (flags & FLAGS_UPPERCASE) && (len < PRINTF_NTOA_BUFFER_SIZE)) {
-				buf[len++] = 'X';
+				*(end - ++len) = 'X';
 			}
 			if (len < PRINTF_NTOA_BUFFER_SIZE) {
-				buf[len++] = '0';
+				*(end - ++len) = '0';
 			}
 		}
 
 		// handle sign
-		if ((len == width) && (negative || (flags & FLAGS_PLUS) || (flags & FLAGS_SPACE))) {
+		if (len && (len == width) && (negative || (flags & FLAGS_PLUS) || (flags & FLAGS_SPACE))) {
 			len--;
 		}
 		if (len < PRINTF_NTOA_BUFFER_SIZE) {
 			if (negative) {
-				buf[len++] = '-';
+				*(end - ++len) = '-';
 			}
 			else if (flags & FLAGS_PLUS) {
-				buf[len++] = '+';  // ignore the space if the '+' exists
+				*(end - ++len) = '+';  // ignore the space if the '+' exists
 			}
 			else if (flags & FLAGS_SPACE) {
-				buf[len++] = ' ';
+				*(end - ++len) = ' ';
 			}
 		}
 
 		// pad spaces up to given width
-		if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD)) {
-			for (size_t i = len; i < width; i++) {
-				out(' ', buffer, idx++, maxlen);
+		if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD) && (len < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - len);
+		}
+
+		// number, in one block
+		out(end - len, len, buffer, idx, maxlen);
+		idx += len;
+
+		// append pad spaces up to given width
+		if ((flags & FLAGS_LEFT) && (idx - start_idx < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - (idx - start_idx));
+		}
+
+		return idx;
+	}
+
+
+	// digits of the power of two bases, lower and upper case
+	constexpr inline const char hex_digits[] = "0123456789abcdef";
+	constexpr inline const char hex_digits_upper[] = "0123456789ABCDEF";
+
+
+	// internal conversion of value into exactly 16 hex digits, leading zeros included
+	PRINTF_EXTERN_C inline void _hex16(char* out, unsigned long long value, unsigned int flags)
+	{
+#if defined(PRINTF_SUPPORT_AVX2) || defined(PRINTF_SUPPORT_SSE2)
+		// most significant byte first, then its nibbles interleaved high, low
+#if defined(_MSC_VER)
+		const unsigned long long swapped = _byteswap_uint64(value);
+#else
+		const unsigned long long swapped = __builtin_bswap64(value);
+#endif
+		const __m128i bytes = _mm_loadl_epi64((const __m128i*)&swapped);
+		const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+		const __m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibbles), _mm_and_si128(bytes, low_nibbles));
+#if defined(PRINTF_SUPPORT_AVX2)
+		const __m128i digits = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)((flags & FLAGS_UPPERCASE) ? hex_digits_upper : hex_digits)), nibbles);
+#else
+		const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8((flags & FLAGS_UPPERCASE) ? 'A' - '0' - 10 : 'a' - '0' - 10));
+		const __m128i digits = _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+#endif
+		_mm_storeu_si128((__m128i*)out, digits);
+#else
+		// SWAR, each half spread to one nibble per byte
+		const unsigned long long letter = (flags & FLAGS_UPPERCASE) ? 'A' - '0' - 10 : 'a' - '0' - 10;
+		for (unsigned int half = 0U; half < 2U; half++) {
+			unsigned long long x = (value >> (half ? 0U : 32U)) & 0xFFFFFFFFULL;
+			x = (x | (x << 16U)) & 0x0000FFFF0000FFFFULL;
+			x = (x | (x << 8U)) & 0x00FF00FF00FF00FFULL;
+			x = (x | (x << 4U)) & 0x0F0F0F0F0F0F0F0FULL;
+			const unsigned long long letters = ((x + 0x0606060606060606ULL) >> 4U) & 0x0101010101010101ULL;
+			x += 0x3030303030303030ULL + letters * letter;
+			for (unsigned int i = 0U; i < 8U; i++) {
+				out[half * 8U + 7U - i] = (char)(x >> (i * 8U));
 			}
 		}
+#endif
+	}
 
-		// reverse string
-		for (size_t i = 0U; i < len; i++) {
-			out(buf[len - i - 1U], buffer, idx++, maxlen);
+
+	// internal count of the decimal digits of value
+	template <typename T>
+	inline unsigned int _count_digits10(T value)
+	{
+		// log10 estimated from log2, then corrected by one comparison
+		const unsigned int bits = 64U - _clz((unsigned long long)value | 1U);
+		const unsigned int digits = (bits * 1233U) >> 12U;
+		return digits + ((value | 1U) >= (T)pow10_table[digits] ? 1U : 0U);
+	}
+
+
+	// internal conversion of value into the last digits of the conversion buffer buf
+	// base 10 is converted two digits at a time, straight into the final position
+	// base 16 is converted in one block by _hex16, 8 and 2 by shift and mask
+	// \return The number of digits
+	template <typename T>
+	inline size_t _ntoa_digits(char* buf, T value, unsigned int base, unsigned int flags)
+	{
+		char* p = buf + PRINTF_NTOA_BUFFER_SIZE;
+
+		if (base == 10U) {
+			const unsigned int len = _count_digits10(value);
+			p -= len;
+			char* digit = p + len;
+			while (value >= 100U) {
+				const unsigned int pair = (unsigned int)(value % 100U) * 2U;
+				value /= 100U;
+				*--digit = digit_pairs[pair + 1U];
+				*--digit = digit_pairs[pair];
+			}
+			if (value >= 10U) {
+				*--digit = digit_pairs[(unsigned int)value * 2U + 1U];
+				*--digit = digit_pairs[(unsigned int)value * 2U];
+			}
+			else {
+				*--digit = (char)('0' + (unsigned int)value);
+			}
+			return len;
 		}
 
-		// append pad spaces up to given width
-		if (flags & FLAGS_LEFT) {
-			while (idx - start_idx < width) {
-				out(' ', buffer, idx++, maxlen);
+		if (base == 16U) {
+			// all 16 digits at once, the leading zeros are cut by the digit count
+			const unsigned int len = (64U - _clz((unsigned long long)value | 1U) + 3U) / 4U;
+			_hex16(p - 16, (unsigned long long)value, flags);
+			return len;
+		}
+
+		if ((base & (base - 1U)) == 0U) {
+			// 2 and 8 by shift and mask, the digit count comes from the leading zeros
+			const unsigned int shift = (base == 8U) ? 3U : 1U;
+			const unsigned int mask = base - 1U;
+			const char* const digits = (flags & FLAGS_UPPERCASE) ? hex_digits_upper : hex_digits;
+			unsigned int len = (64U - _clz((unsigned long long)value | 1U) + shift - 1U) / shift;
+			if (len > PRINTF_NTOA_BUFFER_SIZE) {
+				len = PRINTF_NTOA_BUFFER_SIZE;
+			}
+			for (unsigned int i = 0U; i < len; i++) {
+				*--p = digits[(unsigned int)value & mask];
+				value >>= shift;
 			}
+			return len;
 		}
 
-		return idx;
+		do {
+			const char digit = (char)(value % base);
+			*--p = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+			value /= base;
+		} while (value && (p > buf));
+		return (size_t)(buf + PRINTF_NTOA_BUFFER_SIZE - p);
+	}
+
+
+	// internal count of the digits _ntoa_digits would write, without writing them
+	template <typename T>
+	inline size_t _ntoa_count(T value, unsigned int base)
+	{
+		if (base == 10U) {
+			return _count_digits10(value);
+		}
+		const unsigned int shift = (base == 16U) ? 4U : (base == 8U) ? 3U : 1U;
+		const unsigned int len = (64U - _clz((unsigned long long)value | 1U) + shift - 1U) / shift;
+		return len < PRINTF_NTOA_BUFFER_SIZE ? len : PRINTF_NTOA_BUFFER_SIZE;
 	}
 
 
 	// internal itoa for 'long' type
-	PRINTF_EXTERN_C inline size_t _ntoa_long(out_fct_type out, char* buffer, size_t idx, size_t maxlen, unsigned long value, bool negative, unsigned long base, unsigned int prec, unsigned int width, unsigned int flags)
+	template <typename O>
+	inline size_t _ntoa_long(O out, char* buffer, size_t idx, size_t maxlen, unsigned long value, bool negative, unsigned long base, unsigned int prec, unsigned int width, unsigned int flags)
 	{
 		char buf[PRINTF_NTOA_BUFFER_SIZE];
 		size_t len = 0U;
 
-		// write if precision != 0 and value is != 0
+		// write if precision != 0 and value is != 0, only count when measuring
 		if (!(flags & FLAGS_PRECISION) || value) {
-			do {
-				const char digit = (char)(value % base);
-				buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
-				value /= base;
-			} while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+			len = _is_null_sink(out) ? _ntoa_count(value, (unsigned int)base) : _ntoa_digits(buf, value, (unsigned int)base, flags);
 		}
 
 		return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
@@ -246,18 +951,15 @@ namespace inner {
 
 	// internal itoa for 'long long' type
 #if defined(PRINTF_SUPPORT_LONG_LONG)
-	PRINTF_EXTERN_C  inline size_t _ntoa_long_long(out_fct_type out, char* buffer, size_t idx, size_t maxlen, unsigned long long value, bool negative, unsigned long long base, unsigned int prec, unsigned int width, unsigned int flags)
+	template <typename O>
+	inline size_t _ntoa_long_long(O out, char* buffer, size_t idx, size_t maxlen, unsigned long long value, bool negative, unsigned long long base, unsigned int prec, unsigned int width, unsigned int flags)
 	{
 		char buf[PRINTF_NTOA_BUFFER_SIZE];
 		size_t len = 0U;
 
-		// write if precision != 0 and value is != 0
+		// write if precision != 0 and value is != 0, only count when measuring
 		if (!(flags & FLAGS_PRECISION) || value) {
-			do {
-				const char digit = (char)(value % base);
-				buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
-				value /= base;
-			} while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+			len = _is_null_sink(out) ? _ntoa_count(value, (unsigned int)base) : _ntoa_digits(buf, value, (unsigned int)base, flags);
 		}
 
 		return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
@@ -266,468 +968,3049 @@ namespace inner {
 
 
 #if defined(PRINTF_SUPPORT_FLOAT)
-	PRINTF_EXTERN_C  inline size_t _ftoa(out_fct_type out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
-	{
-		char buf[PRINTF_FTOA_BUFFER_SIZE];
-		size_t len = 0U;
-		double diff = 0.0;
+	// multiword unsigned integer, least significant word first
+	typedef struct {
+		uint32_t word[PRINTF_BIG_WORDS];
+		unsigned int size;  // words in use
+	} big_type;
 
-		// if input is larger than thres_max, revert to exponential
-		const double thres_max = (double)0x7FFFFFFF;
 
-		// powers of 10
-		static const double pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+	// exact decimal digits of a double, its value is 0.digits * 10^point
+	typedef struct {
+		char digits[PRINTF_DTOA_BUFFER_SIZE];
+		int count;  // digits in use, the ones past them are 0
+		int point;
+	} decimal_type;
 
-		// test for negative
-		bool negative = false;
-		if (value < 0) {
-			negative = true;
-			value = 0 - value;
+
+	// internal big = value << shift
+	PRINTF_EXTERN_C inline void _big_set(big_type* big, uint64_t value, unsigned int shift)
+	{
+		const unsigned int word = shift / 32U;
+		const unsigned int bit = shift % 32U;
+		for (unsigned int i = 0U; i < word; i++) {
+			big->word[i] = 0U;
+		}
+		big->word[word] = (uint32_t)(value << bit);
+		big->word[word + 1U] = (uint32_t)(value >> (32U - bit));
+		big->word[word + 2U] = bit ? (uint32_t)(value >> (64U - bit)) : 0U;
+		big->size = word + 3U;
+		while (big->size && !big->word[big->size - 1U]) {
+			big->size--;
+		}
+	}
+
+
+	// internal big *= factor
+	PRINTF_EXTERN_C inline void _big_mul(big_type* big, uint32_t factor)
+	{
+		uint64_t carry = 0U;
+		for (unsigned int i = 0U; i < big->size; i++) {
+			carry += (uint64_t)big->word[i] * factor;
+			big->word[i] = (uint32_t)carry;
+			carry >>= 32U;
+		}
+		if (carry && (big->size < PRINTF_BIG_WORDS)) {
+			big->word[big->size++] = (uint32_t)carry;
+		}
+	}
+
+
+	// internal big /= divisor
+	// \return The remainder
+	PRINTF_EXTERN_C inline uint32_t _big_div(big_type* big, uint32_t divisor)
+	{
+		uint64_t rem = 0U;
+		for (unsigned int i = big->size; i-- > 0U;) {
+			rem = (rem << 32U) | big->word[i];
+			big->word[i] = (uint32_t)(rem / divisor);
+			rem %= divisor;
+		}
+		while (big->size && !big->word[big->size - 1U]) {
+			big->size--;
+		}
+		return (uint32_t)rem;
+	}
+
+
+	// internal split of big at bit 'shift', big keeps the bits below it
+	// \return The bits above it, they must fit into 32 bits
+	PRINTF_EXTERN_C inline uint32_t _big_split(big_type* big, unsigned int shift)
+	{
+		const unsigned int word = shift / 32U;
+		const unsigned int bit = shift % 32U;
+		if (word >= big->size) {
+			return 0U;
+		}
+		uint64_t high = big->word[word] >> bit;
+		if (word + 1U < big->size) {
+			high |= (uint64_t)big->word[word + 1U] << (32U - bit);
+		}
+		big->word[word] &= (1U << bit) - 1U;
+		big->size = word + 1U;
+		while (big->size && !big->word[big->size - 1U]) {
+			big->size--;
+		}
+		return (uint32_t)high;
+	}
+
+
+	// internal append of the 'len' lowest decimal digits of chunk
+	PRINTF_EXTERN_C inline void _dtoa_append(decimal_type* dec, uint32_t chunk, unsigned int len)
+	{
+		for (unsigned int i = len; i-- > 0U;) {
+			dec->digits[dec->count + (int)i] = (char)('0' + chunk % 10U);
+			chunk /= 10U;
+		}
+		dec->count += (int)len;
+	}
+
+
+	// internal exact conversion of the finite, positive value to 'prec' significant digits,
+	// or to 'prec' digits after the decimal point when 'fixed' is set
+	// rounded half to even, the way the value is, not the way it was written
+	PRINTF_EXTERN_C inline void _dtoa(double value, int prec, bool fixed, decimal_type* dec)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint64_t mant = bits & ((1ULL << 52U) - 1U);
+		int exp2 = (int)((bits >> 52U) & 0x7FFU);
+		if (exp2) {
+			mant |= 1ULL << 52U;
+			exp2 -= 1075;
+		}
+		else {
+			exp2 = -1074;
+		}
+
+		dec->count = 0;
+		dec->point = 1;
+		if (!mant) {
+			return;
+		}
+
+		big_type big;
+		bool sticky = false;  // digits dropped past the buffer were not all 0
+		if (exp2 >= 0) {
+			// an integer, 9 digits at a time from the low end
+			uint32_t chunk[PRINTF_BIG_WORDS + 4U];
+			unsigned int n = 0U;
+			_big_set(&big, mant, (unsigned int)exp2);
+			while (big.size) {
+				chunk[n++] = _big_div(&big, 1000000000U);
+			}
+			dec->point = (int)(_count_digits10(chunk[n - 1U]) + 9U * (n - 1U));
+			_dtoa_append(dec, chunk[n - 1U], _count_digits10(chunk[n - 1U]));
+			for (n--; n > 0U; n--) {
+				if (dec->count + 9 <= (int)PRINTF_DTOA_BUFFER_SIZE) {
+					_dtoa_append(dec, chunk[n - 1U], 9U);
+				}
+				else {
+					sticky = sticky || chunk[n - 1U];
+				}
+			}
+		}
+		else {
+			// the integer part fits 64 bits, the fraction has 'shift' bits
+			const unsigned int shift = (unsigned int)-exp2;
+			uint64_t whole = 0U;
+			if (shift < 64U) {
+				whole = mant >> shift;
+				mant &= (1ULL << shift) - 1U;
+			}
+			if (whole) {
+				char buf[PRINTF_NTOA_BUFFER_SIZE];
+				const size_t len = _ntoa_digits(buf, whole, 10U, 0U);
+				std::memcpy(dec->digits, buf + PRINTF_NTOA_BUFFER_SIZE - len, len);
+				dec->count = (int)len;
+			}
+			dec->point = dec->count;
+
+			// the fraction, 9 digits at a time, from the high end
+			_big_set(&big, mant, 0U);
+			while (big.size && (dec->count <= (fixed ? dec->point + prec : prec)) && (dec->count + 9 <= (int)PRINTF_DTOA_BUFFER_SIZE)) {
+				_big_mul(&big, 1000000000U);
+				const uint32_t chunk = _big_split(&big, shift);
+				if (dec->count) {
+					_dtoa_append(dec, chunk, 9U);
+				}
+				else if (chunk) {
+					const unsigned int len = _count_digits10(chunk);
+					dec->point -= 9 - (int)len;
+					_dtoa_append(dec, chunk, len);
+				}
+				else if (fixed && (dec->point - 9 + prec < 0)) {
+					// below half of the last digit, rounds to 0
+					dec->point = 1;
+					return;
+				}
+				else {
+					dec->point -= 9;
+				}
+			}
+			sticky = big.size != 0U;
+		}
+
+		// round half to even at the wanted digit
+		int want = fixed ? dec->point + prec : prec;
+		if (want > (int)PRINTF_DTOA_BUFFER_SIZE - 9) {
+			want = (int)PRINTF_DTOA_BUFFER_SIZE - 9;
+		}
+		if (dec->count <= want) {
+			return;
+		}
+		if (want < 0) {
+			dec->count = 0;
+			dec->point = 1;
+			return;
+		}
+		const char next = dec->digits[want];
+		for (int i = want + 1; (i < dec->count) && !sticky; i++) {
+			sticky = dec->digits[i] != '0';
+		}
+		dec->count = want;
+		if ((next > '5') || ((next == '5') && (sticky || (want && (dec->digits[want - 1] & 1))))) {
+			int i = want - 1;
+			while ((i >= 0) && (dec->digits[i] == '9')) {
+				dec->digits[i--] = '0';
+			}
+			if (i >= 0) {
+				dec->digits[i]++;
+			}
+			else {
+				// 9.99 to 10.0
+				dec->digits[0] = '1';
+				dec->count = want ? want : 1;
+				dec->point++;
+			}
+		}
+		else if (!want) {
+			dec->point = 1;
+		}
+	}
+
+
+	// internal output of the digits at the positions from..from+len of dec, 0 outside of them
+	// \return The index after the last character written
+	template <typename O>
+	inline size_t _out_digits(O out, char* buffer, size_t idx, size_t maxlen, const decimal_type* dec, int from, unsigned int len)
+	{
+		if ((from < 0) && len) {
+			const unsigned int zeros = (unsigned int)-from < len ? (unsigned int)-from : len;
+			idx = _out_fill(out, buffer, idx, maxlen, '0', zeros);
+			from += (int)zeros;
+			len -= zeros;
+		}
+		if (len && (from < dec->count)) {
+			const unsigned int count = (unsigned int)(dec->count - from) < len ? (unsigned int)(dec->count - from) : len;
+			out(dec->digits + from, count, buffer, idx, maxlen);
+			idx += count;
+			len -= count;
+		}
+		return _out_fill(out, buffer, idx, maxlen, '0', len);
+	}
+
+
+	// internal output of dec, with 'prec' fraction digits, in exponential or fixed notation
+	// \return The index after the last character written
+	template <typename O>
+	inline size_t _out_decimal(O out, char* buffer, size_t idx, size_t maxlen, const decimal_type* dec, bool exponential, unsigned int prec, bool negative, unsigned int width, unsigned int flags)
+	{
+		const size_t start_idx = idx;
+
+		// the digits before the decimal point are at the positions 0..point
+		const int point = exponential ? 1 : dec->point;
+		char exp_buf[8];
+		size_t exp_len = 0U;
+		if (exponential) {
+			int exp10 = dec->count ? dec->point - 1 : 0;
+			exp_buf[exp_len++] = (flags & FLAGS_UPPERCASE) ? 'E' : 'e';
+			exp_buf[exp_len++] = exp10 < 0 ? '-' : '+';
+			exp10 = exp10 < 0 ? -exp10 : exp10;
+			if (exp10 >= 100) {
+				exp_buf[exp_len++] = (char)('0' + exp10 / 100);
+			}
+			exp_buf[exp_len++] = (char)('0' + exp10 / 10 % 10);
+			exp_buf[exp_len++] = (char)('0' + exp10 % 10);
+		}
+
+		const char sign = negative ? '-' : (flags & FLAGS_PLUS) ? '+' : (flags & FLAGS_SPACE) ? ' ' : '\0';
+		const bool dot = prec || (flags & FLAGS_HASH);
+		const size_t len = (sign ? 1U : 0U) + (point > 0 ? (size_t)point : 1U) + (dot ? 1U : 0U) + prec + exp_len;
+
+		// pad spaces up to given width
+		if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD) && (len < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - len);
+		}
+		if (sign) {
+			out(&sign, 1U, buffer, idx++, maxlen);
+		}
+		// pad leading zeros, after the sign
+		if (!(flags & FLAGS_LEFT) && (flags & FLAGS_ZEROPAD) && (len < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, '0', width - len);
+		}
+
+		if (point > 0) {
+			idx = _out_digits(out, buffer, idx, maxlen, dec, 0, (unsigned int)point);
+		}
+		else {
+			out("0", 1U, buffer, idx++, maxlen);
+		}
+		if (dot) {
+			out(".", 1U, buffer, idx++, maxlen);
+		}
+		idx = _out_digits(out, buffer, idx, maxlen, dec, point, prec);
+		if (exp_len) {
+			out(exp_buf, exp_len, buffer, idx, maxlen);
+			idx += exp_len;
+		}
+
+		// append pad spaces up to given width
+		if ((flags & FLAGS_LEFT) && (idx - start_idx < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - (idx - start_idx));
+		}
+		return idx;
+	}
+
+
+	// internal output of nan and inf
+	// \return The index after the last character written
+	template <typename O>
+	inline size_t _out_special(O out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int width, unsigned int flags)
+	{
+		char buf[4];
+		size_t len = 0U;
+		if (std::signbit(value)) {
+			buf[len++] = '-';
+		}
+		else if (flags & FLAGS_PLUS) {
+			buf[len++] = '+';
+		}
+		else if (flags & FLAGS_SPACE) {
+			buf[len++] = ' ';
+		}
+		std::memcpy(buf + len, (value != value) ? ((flags & FLAGS_UPPERCASE) ? "NAN" : "nan") : ((flags & FLAGS_UPPERCASE) ? "INF" : "inf"), 3U);
+		len += 3U;
+
+		// space padded only
+		if (!(flags & FLAGS_LEFT) && (len < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - len);
+		}
+		out(buf, len, buffer, idx, maxlen);
+		idx += len;
+		if ((flags & FLAGS_LEFT) && (len < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - len);
+		}
+		return idx;
+	}
+
+
+	// internal exact %f conversion, every digit of the integer part is written
+	template <typename O>
+	inline size_t _ftoa_exact(O out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+	{
+		if ((value != value) || (value - value != value - value)) {
+			return _out_special(out, buffer, idx, maxlen, value, width, flags);
+		}
+		const bool negative = std::signbit(value);
+		if (negative) {
+			value = -value;
+		}
+
+		// set default precision to 6, if not set explicitly
+		if (!(flags & FLAGS_PRECISION)) {
+			prec = 6U;
+		}
+
+		decimal_type dec;
+		_dtoa(value, prec < PRINTF_DTOA_FRACTION_MAX ? (int)prec : (int)PRINTF_DTOA_FRACTION_MAX, true, &dec);
+		return _out_decimal(out, buffer, idx, maxlen, &dec, false, prec, negative, width, flags);
+	}
+
+
+	// internal 64 x 64 to 128 bit multiplication
+	// \return The low 64 bits, the high ones are stored at 'high'
+	PRINTF_EXTERN_C inline uint64_t _mul128(uint64_t a, uint64_t b, uint64_t* high)
+	{
+#if defined(__SIZEOF_INT128__)
+		const unsigned __int128 product = (unsigned __int128)a * b;
+		*high = (uint64_t)(product >> 64U);
+		return (uint64_t)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+		return _umul128(a, b, high);
+#else
+		const uint64_t a_lo = a & 0xFFFFFFFFU, a_hi = a >> 32U;
+		const uint64_t b_lo = b & 0xFFFFFFFFU, b_hi = b >> 32U;
+		const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+		const uint64_t cross = (lo_lo >> 32U) + (hi_lo & 0xFFFFFFFFU) + lo_hi;
+		*high = a_hi * b_hi + (hi_lo >> 32U) + (cross >> 32U);
+		return (cross << 32U) | (lo_lo & 0xFFFFFFFFU);
+#endif
+	}
+
+
+	// internal %f conversion
+	// the integer part and the fraction of most values fit 64 bits each, then the digits of
+	// a precision up to 19 come from one 64 x 64 to 128 bit multiplication of the fraction
+	template <typename O>
+	inline size_t _ftoa(O out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+	{
+		// set default precision to 6, if not set explicitly
+		if (!(flags & FLAGS_PRECISION)) {
+			prec = 6U;
+			flags |= FLAGS_PRECISION;
+		}
+
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const bool negative = (bits >> 63U) != 0U;
+		const int exp2 = (int)((bits >> 52U) & 0x7FFU) - 1075;
+		uint64_t mant = bits & ((1ULL << 52U) - 1U);
+		uint64_t whole = 0U;
+		uint64_t frac = 0U;  // 64 bit binary fraction
+		if ((prec <= 19U) && (exp2 >= -64) && (exp2 <= 11)) {
+			mant |= 1ULL << 52U;
+			if (exp2 >= 0) {
+				whole = mant << exp2;
+			}
+			else {
+				whole = exp2 > -64 ? mant >> -exp2 : 0U;
+				frac = exp2 > -64 ? mant << (64 + exp2) : mant;
+			}
+		}
+		else if ((prec > 19U) || (exp2 != -1075) || mant) {
+			// the large, the small, nan and inf, +-0 stays here up to the precision of the digits
+			return _ftoa_exact(out, buffer, idx, maxlen, value, prec, width, flags);
+		}
+
+		// the fraction digits, rounded half to even on the bits below them
+		uint64_t digits = 0U;
+		if (frac) {
+			const uint64_t low = _mul128(frac, pow10_table[prec], &digits);
+			if ((low > (1ULL << 63U)) || ((low == (1ULL << 63U)) && ((prec ? digits : whole) & 1U))) {
+				if (!prec || (++digits == pow10_table[prec])) {
+					digits = 0U;
+					whole++;
+				}
+			}
+		}
+
+		decimal_type dec;
+		char buf[PRINTF_NTOA_BUFFER_SIZE];
+		dec.count = 0;
+		if (_is_null_sink(out)) {
+			// measuring, the layout needs the number of integer digits only
+			dec.point = whole ? (int)_count_digits10(whole) : 0;
+			return _out_decimal(out, buffer, idx, maxlen, &dec, false, prec, negative, width, flags);
+		}
+		if (whole) {
+			const size_t len = _ntoa_digits(buf, whole, 10U, 0U);
+			std::memcpy(dec.digits, buf + PRINTF_NTOA_BUFFER_SIZE - len, len);
+			dec.count = (int)len;
+		}
+		dec.point = dec.count;
+		if (prec) {
+			const size_t len = _ntoa_digits(buf, digits, 10U, 0U);
+			std::memset(dec.digits + dec.count, '0', prec - len);
+			std::memcpy(dec.digits + dec.count + prec - len, buf + PRINTF_NTOA_BUFFER_SIZE - len, len);
+			dec.count += (int)prec;
+		}
+		return _out_decimal(out, buffer, idx, maxlen, &dec, false, prec, negative, width, flags);
+	}
+
+
+	// internal %a conversion, the bits of the double in hex, rounded half to even to 'prec' digits
+	template <typename O>
+	inline size_t _atoa(O out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+	{
+		if ((value != value) || (value - value != value - value)) {
+			return _out_special(out, buffer, idx, maxlen, value, width, flags);
+		}
+		const size_t start_idx = idx;
+		const char* const hex = (flags & FLAGS_UPPERCASE) ? hex_digits_upper : hex_digits;
+
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const bool negative = (bits >> 63U) != 0U;
+		const unsigned int biased = (unsigned int)((bits >> 52U) & 0x7FFU);
+		uint64_t mant = bits & ((1ULL << 52U) - 1U);
+		unsigned int lead = biased ? 1U : 0U;
+		const int exp2 = biased ? (int)biased - 1023 : (mant ? -1022 : 0);
+
+		// 13 hex digits of mantissa, without the trailing zeros unless a precision is given
+		unsigned int digits = 13U;
+		unsigned int zeros = 0U;
+		if (!(flags & FLAGS_PRECISION)) {
+			while (digits && !(mant & 0xFU)) {
+				mant >>= 4U;
+				digits--;
+			}
+		}
+		else if (prec < 13U) {
+			const unsigned int shift = (13U - prec) * 4U;
+			const uint64_t rest = mant & ((1ULL << shift) - 1U);
+			const uint64_t half = 1ULL << (shift - 1U);
+			mant >>= shift;
+			digits = prec;
+			if ((rest > half) || ((rest == half) && ((prec ? mant : lead) & 1U))) {
+				if (++mant >> (prec * 4U)) {
+					// 0x1.f to 0x2.0
+					mant = 0U;
+					lead++;
+				}
+			}
+		}
+		else {
+			zeros = prec - 13U;
+		}
+
+		char buf[32];
+		size_t len = 0U;
+		if (negative) {
+			buf[len++] = '-';
+		}
+		else if (flags & FLAGS_PLUS) {
+			buf[len++] = '+';
+		}
+		else if (flags & FLAGS_SPACE) {
+			buf[len++] = ' ';
+		}
+		buf[len++] = '0';
+		buf[len++] = (flags & FLAGS_UPPERCASE) ? 'X' : 'x';
+		const size_t prefix_len = len;
+		buf[len++] = hex[lead];
+		if (digits || zeros || (flags & FLAGS_HASH)) {
+			buf[len++] = '.';
+		}
+		for (unsigned int i = digits; i-- > 0U;) {
+			buf[len++] = hex[(mant >> (i * 4U)) & 0xFU];
+		}
+		const size_t mant_len = len;
+
+		// binary exponent, in decimal
+		buf[len++] = (flags & FLAGS_UPPERCASE) ? 'P' : 'p';
+		buf[len++] = exp2 < 0 ? '-' : '+';
+		char exp_buf[PRINTF_NTOA_BUFFER_SIZE];
+		const size_t exp_len = _ntoa_digits(exp_buf, (unsigned int)(exp2 < 0 ? -exp2 : exp2), 10U, 0U);
+		std::memcpy(buf + len, exp_buf + PRINTF_NTOA_BUFFER_SIZE - exp_len, exp_len);
+		len += exp_len;
+
+		// pad spaces up to given width, or zeros after the 0x
+		const size_t total = len + zeros;
+		if (!(flags & FLAGS_LEFT) && (total < width)) {
+			if (flags & FLAGS_ZEROPAD) {
+				out(buf, prefix_len, buffer, idx, maxlen);
+				idx = _out_fill(out, buffer, idx + prefix_len, maxlen, '0', width - total);
+				out(buf + prefix_len, mant_len - prefix_len, buffer, idx, maxlen);
+				idx += mant_len - prefix_len;
+			}
+			else {
+				idx = _out_fill(out, buffer, idx, maxlen, ' ', width - total);
+				out(buf, mant_len, buffer, idx, maxlen);
+				idx += mant_len;
+			}
+		}
+		else {
+			out(buf, mant_len, buffer, idx, maxlen);
+			idx += mant_len;
+		}
+		idx = _out_fill(out, buffer, idx, maxlen, '0', zeros);
+		out(buf + mant_len, len - mant_len, buffer, idx, maxlen);
+		idx += len - mant_len;
+
+		// append pad spaces up to given width
+		if ((flags & FLAGS_LEFT) && (idx - start_idx < width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', width - (idx - start_idx));
+		}
+		return idx;
+	}
+
+
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+	// internal %e and %g conversion, %g when FLAGS_ADAPT_EXP is set
+	template <typename O>
+	inline size_t _etoa(O out, char* buffer, size_t idx, size_t maxlen, double value, unsigned int prec, unsigned int width, unsigned int flags)
+	{
+		if ((value != value) || (value - value != value - value)) {
+			return _out_special(out, buffer, idx, maxlen, value, width, flags);
+		}
+		const bool negative = std::signbit(value);
+		if (negative) {
+			value = -value;
 		}
 
 		// set default precision to 6, if not set explicitly
 		if (!(flags & FLAGS_PRECISION)) {
 			prec = 6U;
 		}
-		// limit precision to 9, cause a prec >= 10 can lead to overflow errors
-		while ((len < PRINTF_FTOA_BUFFER_SIZE) && (prec > 9U)) {
-			buf[len++] = '0';
-			prec--;
+
+		decimal_type dec;
+		if (!(flags & FLAGS_ADAPT_EXP)) {
+			_dtoa(value, prec < PRINTF_DTOA_BUFFER_SIZE ? (int)prec + 1 : (int)PRINTF_DTOA_BUFFER_SIZE, false, &dec);
+			return _out_decimal(out, buffer, idx, maxlen, &dec, true, prec, negative, width, flags);
+		}
+
+		// %g, 'prec' significant digits, in fixed notation when the exponent is in -4..prec
+		if (!prec) {
+			prec = 1U;
+		}
+		_dtoa(value, prec < PRINTF_DTOA_BUFFER_SIZE ? (int)prec : (int)PRINTF_DTOA_BUFFER_SIZE, false, &dec);
+		const int exp10 = dec.count ? dec.point - 1 : 0;
+		const bool exponential = (exp10 < -4) || (exp10 >= (int)prec);
+		prec = exponential ? prec - 1U : (unsigned int)((int)prec - 1 - exp10);
+
+		// trailing zeros are removed, unless the '#' flag is given
+		if (!(flags & FLAGS_HASH)) {
+			const int first = exponential ? 1 : dec.point;
+			const unsigned int stored = dec.count > first ? (unsigned int)(dec.count - first) : 0U;
+			if (prec > stored) {
+				prec = stored;
+			}
+			while (prec && (dec.digits[first + (int)prec - 1] == '0')) {
+				prec--;
+			}
+		}
+		return _out_decimal(out, buffer, idx, maxlen, &dec, exponential, prec, negative, width, flags);
+	}
+#endif  // PRINTF_SUPPORT_EXPONENTIAL
+#endif  // PRINTF_SUPPORT_FLOAT
+
+
+	// internal parse of a conversion specification, format points past the '%'
+	// \return Pointer past the specifier
+	PRINTF_EXTERN_C constexpr inline const char* _parse_spec(const char* format, spec_type* spec)
+	{
+		unsigned int flags = 0U, width = 0U, precision = 0U, n = 0U;
+
+		// evaluate flags
+		do {
+			switch (*format) {
+			case '0': flags |= FLAGS_ZEROPAD; format++; n = 1U; break;
+			case '-': flags |= FLAGS_LEFT;    format++; n = 1U; break;
+			case '+': flags |= FLAGS_PLUS;    format++; n = 1U; break;
+			case ' ': flags |= FLAGS_SPACE;   format++; n = 1U; break;
+			case '#': flags |= FLAGS_HASH;    format++; n = 1U; break;
+			default:                                   n = 0U; break;
+			}
+		} while (n);
+
+		// evaluate width field
+		if (_is_digit(*format)) {
+			width = _atoi(&format);
+		}
+		else if (*format == '*') {
+			flags |= FLAGS_WIDTH_ARG;
+			format++;
+		}
+
+		// evaluate precision field
+		if (*format == '.') {
+			flags |= FLAGS_PRECISION;
+			format++;
+			if (_is_digit(*format)) {
+				precision = _atoi(&format);
+			}
+			else if (*format == '*') {
+				flags |= FLAGS_PRECISION_ARG;
+				format++;
+			}
+		}
+
+		// evaluate length field
+		switch (*format) {
+		case 'l':
+			flags |= FLAGS_LONG;
+			format++;
+			if (*format == 'l') {
+				flags |= FLAGS_LONG_LONG;
+				format++;
+			}
+			break;
+		case 'h':
+			flags |= FLAGS_SHORT;
+			format++;
+			if (*format == 'h') {
+				flags |= FLAGS_CHAR;
+				format++;
+			}
+			break;
+#if defined(PRINTF_SUPPORT_PTRDIFF_T)
+		case 't':
+			flags |= (sizeof(ptrdiff_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+			format++;
+			break;
+#endif
+		case 'j':
+			flags |= (sizeof(intmax_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+			format++;
+			break;
+		case 'z':
+			flags |= (sizeof(size_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
+			format++;
+			break;
+		default:
+			break;
+		}
+
+		spec->flags = flags;
+		spec->width = width;
+		spec->precision = precision;
+		spec->specifier = *format;
+
+		// a '%' at the very end of the format has no specifier
+		return *format ? format + 1 : format;
+	}
+
+
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+	// conversion counters of a thread, only it writes them, format_stats() reads them
+	typedef struct {
+		std::atomic<size_t> calls;
+		std::atomic<size_t> bytes;
+		std::atomic<size_t> truncated;
+		std::atomic<size_t> specifiers[PRINTF_STATS_SPECIFIERS];
+		std::atomic<size_t> flags[PRINTF_STATS_FLAGS];
+	} format_counters_type;
+
+
+	// counters of a thread, in the list of all of them while it runs
+	struct format_counters_node_type {
+		format_counters_type counters{};
+		format_counters_node_type* next = nullptr;
+
+		format_counters_node_type();
+		~format_counters_node_type();
+	};
+
+
+	inline std::mutex format_counters_mutex;
+	inline format_counters_node_type* format_counters_threads = nullptr;
+	inline format_counters_type format_counters_retired{};    // of the threads gone
+
+
+	// internal sum of counters, the source is still counting
+	inline void _counters_add(format_counters_type* to, const format_counters_type* from)
+	{
+		to->calls.fetch_add(from->calls.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		to->bytes.fetch_add(from->bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		to->truncated.fetch_add(from->truncated.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		for (unsigned int i = 0U; i < PRINTF_STATS_SPECIFIERS; ++i) {
+			to->specifiers[i].fetch_add(from->specifiers[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0U; i < PRINTF_STATS_FLAGS; ++i) {
+			to->flags[i].fetch_add(from->flags[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+
+	inline format_counters_node_type::format_counters_node_type()
+	{
+		std::lock_guard<std::mutex> lock(format_counters_mutex);
+		next = format_counters_threads;
+		format_counters_threads = this;
+	}
+
+
+	inline format_counters_node_type::~format_counters_node_type()
+	{
+		std::lock_guard<std::mutex> lock(format_counters_mutex);
+		_counters_add(&format_counters_retired, &counters);
+		for (format_counters_node_type** node = &format_counters_threads; *node; node = &(*node)->next) {
+			if (*node == this) {
+				*node = next;
+				break;
+			}
+		}
+	}
+
+
+	// internal counters of this thread
+	inline format_counters_type* _counters()
+	{
+		static thread_local format_counters_node_type node;
+		return &node.counters;
+	}
+
+
+	// internal increment by the owner thread, a plain add, no locked instruction
+	inline void _count(std::atomic<size_t>* counter, size_t n = 1U)
+	{
+		counter->store(counter->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+#endif  // PRINTF_SUPPORT_INSTRUMENTATION
+
+
+	// internal count of a conversion, nothing unless PRINTF_SUPPORT_INSTRUMENTATION is defined
+	// the flag combination is the flags 0 - + space # as bits 0 to 4, a width as bit 5, and a precision as bit 6
+	PRINTF_EXTERN_C inline void _instrument_spec(const spec_type* spec)
+	{
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+		format_counters_type* counters = _counters();
+		_count(&counters->specifiers[(unsigned char)spec->specifier & (PRINTF_STATS_SPECIFIERS - 1U)]);
+		const unsigned int flags = (spec->flags & (FLAGS_ZEROPAD | FLAGS_LEFT | FLAGS_PLUS | FLAGS_SPACE | FLAGS_HASH)) |
+			((spec->width || (spec->flags & FLAGS_WIDTH_ARG)) ? 32U : 0U) | (spec->flags & (FLAGS_PRECISION | FLAGS_PRECISION_ARG) ? 64U : 0U);
+		_count(&counters->flags[flags]);
+#else
+		(void)spec;
+#endif
+	}
+
+
+	// internal count of a formatting call, its complete output and whether it was cut
+	template <typename O>
+	inline void _instrument_call(O out, size_t idx, size_t maxlen)
+	{
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+		format_counters_type* counters = _counters();
+		_count(&counters->calls);
+		_count(&counters->bytes, idx);
+		if ((idx >= maxlen) && !_is_null_sink(out)) {
+			_count(&counters->truncated);
+		}
+#else
+		(void)out; (void)idx; (void)maxlen;
+#endif
+	}
+
+
+	// internal integer conversion, for the d, i, u, x, X, o and b specifiers
+	// value is the magnitude, the sign is given separately
+	template <typename O>
+	inline size_t _format_integer(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* spec, unsigned long long value, bool negative)
+	{
+		unsigned int flags = spec->flags;
+
+		// set the base
+		unsigned int base;
+		if (spec->specifier == 'x' || spec->specifier == 'X') {
+			base = 16U;
+		}
+		else if (spec->specifier == 'o') {
+			base = 8U;
+		}
+		else if (spec->specifier == 'b') {
+			base = 2U;
+			flags &= ~FLAGS_HASH;   // no hash for bin format
+		}
+		else {
+			base = 10U;
+			flags &= ~FLAGS_HASH;   // no hash for dec format
+		}
+		// uppercase
+		if (spec->specifier == 'X') {
+			flags |= FLAGS_UPPERCASE;
+		}
+
+		// no plus or space flag for u, x, X, o, b
+		if ((spec->specifier != 'i') && (spec->specifier != 'd')) {
+			flags &= ~(FLAGS_PLUS | FLAGS_SPACE);
+		}
+
+		// convert the integer
+		if (flags & FLAGS_LONG_LONG) {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+			return _ntoa_long_long(out, buffer, idx, maxlen, value, negative, base, spec->precision, spec->width, flags);
+#else
+			return idx;
+#endif
+		}
+		return _ntoa_long(out, buffer, idx, maxlen, (unsigned long)value, negative, base, spec->precision, spec->width, flags);
+	}
+
+
+	// internal pointer conversion, for the p specifier
+	template <typename O>
+	inline size_t _format_pointer(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* spec, uintptr_t value)
+	{
+		const unsigned int width = sizeof(void*) * 2U;
+		const unsigned int flags = spec->flags | FLAGS_ZEROPAD | FLAGS_UPPERCASE;
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+		const bool is_ll = sizeof(uintptr_t) == sizeof(long long);
+		if (is_ll) {
+			return _ntoa_long_long(out, buffer, idx, maxlen, value, false, 16U, spec->precision, width, flags);
+		}
+#endif
+		return _ntoa_long(out, buffer, idx, maxlen, (unsigned long)value, false, 16U, spec->precision, width, flags);
+	}
+
+
+	// internal character conversion, for the c specifier
+	template <typename O>
+	inline size_t _format_char(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* spec, char c)
+	{
+		// pre padding
+		if (!(spec->flags & FLAGS_LEFT) && (spec->width > 1U)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', spec->width - 1U);
+		}
+		// char output
+		out(&c, 1U, buffer, idx++, maxlen);
+		// post padding
+		if ((spec->flags & FLAGS_LEFT) && (spec->width > 1U)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', spec->width - 1U);
+		}
+		return idx;
+	}
+
+
+	// internal string conversion, for the s specifier
+	// at most 'size' characters of the string are used, it need not be 0 terminated beyond that
+	template <typename O>
+	inline size_t _format_string(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* spec, const char* p, size_t size)
+	{
+		if ((spec->flags & FLAGS_PRECISION) && (spec->precision < size)) {
+			size = spec->precision;
+		}
+		const unsigned int l = _strnlen_s(p, size);
+		// pre padding
+		if (!(spec->flags & FLAGS_LEFT) && (l < spec->width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', spec->width - l);
+		}
+		// string output
+		out(p, l, buffer, idx, maxlen);
+		idx += l;
+		// post padding
+		if ((spec->flags & FLAGS_LEFT) && (l < spec->width)) {
+			idx = _out_fill(out, buffer, idx, maxlen, ' ', spec->width - l);
+		}
+		return idx;
+	}
+
+
+#if defined(PRINTF_SUPPORT_FLOAT)
+	// internal floating point conversion, for the f, e, g and a specifiers
+	template <typename O>
+	inline size_t _format_float(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* spec, double value)
+	{
+		switch (spec->specifier) {
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+		case 'e':
+			return _etoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags);
+		case 'E':
+			return _etoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags | FLAGS_UPPERCASE);
+		case 'g':
+			return _etoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags | FLAGS_ADAPT_EXP);
+		case 'G':
+			return _etoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags | FLAGS_ADAPT_EXP | FLAGS_UPPERCASE);
+#endif  // PRINTF_SUPPORT_EXPONENTIAL
+		case 'F':
+			return _ftoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags | FLAGS_UPPERCASE);
+		case 'a':
+			return _atoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags);
+		case 'A':
+			return _atoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags | FLAGS_UPPERCASE);
+		default:
+			return _ftoa(out, buffer, idx, maxlen, value, spec->precision, spec->width, spec->flags);
+		}
+	}
+#endif  // PRINTF_SUPPORT_FLOAT
+
+
+	// internal conversion of one specification, taking its arguments from the va_list
+	// \return The index after the last character written
+	template <typename O>
+	inline size_t _format_spec(O out, char* buffer, size_t idx, size_t maxlen, const spec_type* format_spec, va_list* va)
+	{
+		spec_type spec = *format_spec;
+		_instrument_spec(&spec);
+
+		// width and precision given as arguments
+		if (spec.flags & FLAGS_WIDTH_ARG) {
+			const int w = va_arg(*va, int);
+			if (w < 0) {
+				spec.flags |= FLAGS_LEFT;    // reverse padding
+				spec.width = (unsigned int)-w;
+			}
+			else {
+				spec.width = (unsigned int)w;
+			}
+		}
+		if (spec.flags & FLAGS_PRECISION_ARG) {
+			const int prec = va_arg(*va, int);
+			if (prec < 0) {
+				spec.flags &= ~FLAGS_PRECISION;    // a negative precision is taken as omitted
+			}
+			else {
+				spec.precision = (unsigned int)prec;
+			}
+		}
+
+		// evaluate specifier
+		switch (spec.specifier) {
+		case 'd':
+		case 'i':
+			// signed
+			if (spec.flags & FLAGS_LONG_LONG) {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+				const long long value = va_arg(*va, long long);
+				return _format_integer(out, buffer, idx, maxlen, &spec, value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value, value < 0);
+#else
+				return idx;
+#endif
+			}
+			else if (spec.flags & FLAGS_LONG) {
+				const long value = va_arg(*va, long);
+				return _format_integer(out, buffer, idx, maxlen, &spec, value < 0 ? 0UL - (unsigned long)value : (unsigned long)value, value < 0);
+			}
+			else {
+				const int value = (spec.flags & FLAGS_CHAR) ? (char)va_arg(*va, int) : (spec.flags & FLAGS_SHORT) ? (short int)va_arg(*va, int) : va_arg(*va, int);
+				return _format_integer(out, buffer, idx, maxlen, &spec, value < 0 ? 0U - (unsigned int)value : (unsigned int)value, value < 0);
+			}
+
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'b':
+			// unsigned
+			if (spec.flags & FLAGS_LONG_LONG) {
+#if defined(PRINTF_SUPPORT_LONG_LONG)
+				return _format_integer(out, buffer, idx, maxlen, &spec, va_arg(*va, unsigned long long), false);
+#else
+				return idx;
+#endif
+			}
+			else if (spec.flags & FLAGS_LONG) {
+				return _format_integer(out, buffer, idx, maxlen, &spec, va_arg(*va, unsigned long), false);
+			}
+			else {
+				const unsigned int value = (spec.flags & FLAGS_CHAR) ? (unsigned char)va_arg(*va, unsigned int) : (spec.flags & FLAGS_SHORT) ? (unsigned short int)va_arg(*va, unsigned int) : va_arg(*va, unsigned int);
+				return _format_integer(out, buffer, idx, maxlen, &spec, value, false);
+			}
+
+#if defined(PRINTF_SUPPORT_FLOAT)
+		case 'f':
+		case 'F':
+		case 'a':
+		case 'A':
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+#endif  // PRINTF_SUPPORT_EXPONENTIAL
+			return _format_float(out, buffer, idx, maxlen, &spec, va_arg(*va, double));
+#endif  // PRINTF_SUPPORT_FLOAT
+
+		case 'c':
+			return _format_char(out, buffer, idx, maxlen, &spec, (char)va_arg(*va, int));
+
+		case 's':
+			return _format_string(out, buffer, idx, maxlen, &spec, va_arg(*va, char*), (size_t)-1);
+
+		case 'p':
+			return _format_pointer(out, buffer, idx, maxlen, &spec, (uintptr_t)va_arg(*va, void*));
+
+		case '\0':
+			return idx;
+
+		default:
+			// '%' and the unknown specifiers are written out as they are
+			out(&spec.specifier, 1U, buffer, idx, maxlen);
+			return idx + 1U;
+		}
+	}
+
+
+	// internal vsnprintf, parsing the format as it goes
+	// with Stop the rest is left out once the buffer is full, and the length returned is
+	// only known to be maxlen or more, see snprintf_trunc()
+	template <bool Stop = false, typename O>
+	inline int _vsnprintf_format(O out, char* buffer, const size_t maxlen, const char* format, va_list va)
+	{
+		size_t idx = 0U;
+		spec_type spec;
+		va_list args;
+		va_copy(args, va);
+
+		while (*format)
+		{
+			// format specifier?  %[flags][width][.precision][length]
+			if (*format != '%') {
+				// no, output the whole literal run up to the next specifier
+				const char* literal = format;
+				format = _find_specifier(format);
+				out(literal, (size_t)(format - literal), buffer, idx, maxlen);
+				idx += (size_t)(format - literal);
+			}
+			else {
+				// yes, evaluate it
+				format = _parse_spec(format + 1, &spec);
+				idx = _format_spec(out, buffer, idx, maxlen, &spec, &args);
+			}
+			if constexpr (Stop) {
+				if (idx && (idx >= maxlen)) {
+					break;
+				}
+			}
+		}
+		va_end(args);
+		_instrument_call(out, idx, maxlen);
+
+		// termination
+		out("", 1U, buffer, idx < maxlen ? idx : maxlen - 1U, maxlen);
+
+		// return written chars without terminating \0
+		return (int)idx;
+	}
+
+
+	// internal vsnprintf of a compiled format, writing to the block output function
+	// the format string is not parsed again, only its literal runs are written out
+	template <typename O>
+	inline int _vsnprintf_ops(O out, char* buffer, const size_t maxlen, const char* format, const format_op_type* ops, va_list va)
+	{
+		size_t idx = 0U;
+		va_list args;
+		va_copy(args, va);
+
+		for (;; ops++) {
+			if (ops->length) {
+				out(format + ops->offset, ops->length, buffer, idx, maxlen);
+				idx += ops->length;
+			}
+			if (!ops->spec.specifier) {
+				break;
+			}
+			idx = _format_spec(out, buffer, idx, maxlen, &ops->spec, &args);
+		}
+		va_end(args);
+		_instrument_call(out, idx, maxlen);
+
+		// termination
+		out("", 1U, buffer, idx < maxlen ? idx : maxlen - 1U, maxlen);
+
+		// return written chars without terminating \0
+		return (int)idx;
+	}
+
+
+	// internal instantiation of the engine for the block output function, call(sink) with the
+	// buffer, null and stdout outputs as sink types, whose output is inlined, and the others as they are
+	template <typename Call>
+	inline int _with_sink(out_block_fct_type out, char* buffer, size_t maxlen, Call call)
+	{
+		if (!buffer || ((out == _out_buffer_block) && !maxlen) || (out == _out_null_block)) {
+			// nothing is written, use null output function and only measure
+			return call(out_null_sink_type{});
+		}
+		if (out == _out_buffer_block) {
+			return call(out_buffer_sink_type{});
+		}
+#if !defined(PRINTF_USER_DEFINED_PUTCHAR)
+		if (out == _out_stdout_block) {
+			return call(out_stdout_sink_type{});
+		}
+#endif
+		return call(out);
+	}
+
+
+	// internal count of the operations of a compiled format
+	PRINTF_EXTERN_C constexpr inline size_t _count_ops(const char* format)
+	{
+		size_t count = 1U;
+		while (*format) {
+			if (*format++ == '%') {
+				spec_type spec{};
+				format = _parse_spec(format, &spec);
+				count++;
+			}
+		}
+		return count;
+	}
+
+
+	// compiled format, N operations
+	template <size_t N>
+	struct format_ops_type {
+		format_op_type op[N];
+	};
+
+
+	// internal compilation of a format into at most max_ops operations
+	// \return The number of operations, 0 if the format needs more than max_ops
+	PRINTF_EXTERN_C constexpr inline size_t _compile_ops(const char* format, format_op_type* ops, size_t max_ops)
+	{
+		const char* const start = format;
+		for (size_t i = 0U; i < max_ops; i++) {
+			const char* literal = format;
+			while (*format && (*format != '%')) {
+				format++;
+			}
+			ops[i].offset = (unsigned int)(literal - start);
+			ops[i].length = (unsigned int)(format - literal);
+			ops[i].spec = spec_type{};
+			if (!*format) {
+				return i + 1U;
+			}
+			format = _parse_spec(format + 1, &ops[i].spec);
+		}
+		return 0U;
+	}
+
+
+	// internal compilation of a format, at compile time when it is a constant
+	template <size_t N>
+	constexpr format_ops_type<N> _compile_format(const char* format)
+	{
+		format_ops_type<N> ops{};
+		_compile_ops(format, ops.op, N);
+		return ops;
+	}
+
+
+	// base of the format types made by PRINTF_FMT, which hold a constant format string
+	struct format_string_tag {};
+
+	template <typename F>
+	constexpr inline bool is_format_string_v = std::is_base_of_v<format_string_tag, F>;
+
+
+	// the format of F compiled once, at compile time
+	template <typename F>
+	struct compiled_format {
+		static constexpr const char* format = F::c_str();
+		static constexpr format_ops_type<_count_ops(F::c_str())> ops = _compile_format<_count_ops(F::c_str())>(F::c_str());
+	};
+
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+	// C++20 format string literal, used as a non type template argument
+	template <size_t N>
+	struct fixed_string {
+		char data[N]{};
+		constexpr fixed_string(const char(&str)[N]) {
+			for (size_t i = 0U; i < N; i++) {
+				data[i] = str[i];
+			}
+		}
+	};
+
+	template <fixed_string S>
+	struct fixed_format : format_string_tag {
+		static constexpr const char* c_str() { return S.data; }
+	};
+#endif
+
+
+	PRINTF_EXTERN_C inline int _snprintf_ops(out_block_fct_type out, char* buffer, size_t count, const char* format, const format_op_type* ops, ...)
+	{
+		va_list va;
+		va_start(va, ops);
+		const int ret = _with_sink(out, buffer, count, [&](auto sink) {
+			return _vsnprintf_ops(sink, buffer, count, format, ops, va);
+		});
+		va_end(va);
+		return ret;
+	}
+
+
+	// format cache entry, compiled at the first use of its format
+	// the format is published once the operations are complete, and the entry never changes after
+	// count 0 marks a format with too many conversions to be cached
+	typedef struct {
+		std::atomic<const char*> format;
+		std::atomic<bool> taken;
+		size_t count;
+		format_op_type op[PRINTF_FORMAT_CACHE_OPS];
+	} format_cache_slot_type;
+
+
+	typedef struct {
+		format_cache_slot_type slot[PRINTF_FORMAT_CACHE_SIZE];
+		std::atomic<size_t> hits;
+		std::atomic<size_t> misses;
+		std::atomic<size_t> entries;
+	} format_cache_type;
+
+
+	// the format cache, formats are told apart by their address only
+	// so a format must not change its content while it is cached (string literals never do)
+	inline format_cache_type format_cache{};
+
+
+	// internal format cache lookup, compiling and adding the format on a miss
+	// lookups only load, they never wait for or lock anything
+	// \return The compiled format, null if it is not cached
+	PRINTF_EXTERN_C inline const format_op_type* _format_cache_ops(const char* format)
+	{
+		constexpr size_t probes = 4U;
+		const size_t hash = (size_t)(((unsigned long long)(uintptr_t)format * 0x9E3779B97F4A7C15ULL) >> 40U);
+
+		for (size_t i = 0U; i < probes; i++) {
+			format_cache_slot_type* slot = &format_cache.slot[(hash + i) & (PRINTF_FORMAT_CACHE_SIZE - 1U)];
+			const char* cached = slot->format.load(std::memory_order_acquire);
+			if (cached == format) {
+				if (!slot->count) {
+					break;
+				}
+				format_cache.hits.fetch_add(1U, std::memory_order_relaxed);
+				return slot->op;
+			}
+			if (!cached && !slot->taken.load(std::memory_order_relaxed) && !slot->taken.exchange(true, std::memory_order_acquire)) {
+				// this thread owns the free entry now
+				slot->count = _compile_ops(format, slot->op, PRINTF_FORMAT_CACHE_OPS);
+				slot->format.store(format, std::memory_order_release);
+				format_cache.entries.fetch_add(1U, std::memory_order_relaxed);
+				format_cache.misses.fetch_add(1U, std::memory_order_relaxed);
+				return slot->count ? slot->op : nullptr;
+			}
+		}
+		format_cache.misses.fetch_add(1U, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+
+	// internal vsnprintf, compiling the format once and reusing it from the format cache
+	template <typename O>
+	inline int _vsnprintf_cached(O out, char* buffer, const size_t maxlen, const char* format, va_list va)
+	{
+		const format_op_type* ops = _format_cache_ops(format);
+		if (ops) {
+			return _vsnprintf_ops(out, buffer, maxlen, format, ops, va);
+		}
+		return _vsnprintf_format(out, buffer, maxlen, format, va);
+	}
+
+
+	// internal vsnprintf, writing to the block output function
+	PRINTF_EXTERN_C  inline int _vsnprintf_block(out_block_fct_type out, char* buffer, const size_t maxlen, const char* format, va_list va)
+	{
+		return _with_sink(out, buffer, maxlen, [&](auto sink) {
+			return _vsnprintf_format(sink, buffer, maxlen, format, va);
+		});
+	}
+
+
+	// internal vsnprintf into a buffer, stopping at the first character which does not fit
+	PRINTF_EXTERN_C inline int _vsnprintf_stop(char* buffer, const size_t maxlen, const char* format, va_list va)
+	{
+		return _with_sink(_out_buffer_block, buffer, maxlen, [&](auto sink) {
+			return _vsnprintf_format<true>(sink, buffer, maxlen, format, va);
+		});
+	}
+
+
+	// internal test if the specifier converts an argument
+	PRINTF_EXTERN_C constexpr inline bool _takes_arg(char specifier)
+	{
+		switch (specifier) {
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b':
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		case 'c': case 's': case 'p':
+			return true;
+		default:
+			return false;
+		}
+	}
+
+
+	// internal test if the argument type suits the specifier
+	PRINTF_EXTERN_C constexpr inline bool _arg_matches(char specifier, unsigned int type)
+	{
+		switch (specifier) {
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b':
+		case 'c':
+			return (type == ARG_SIGNED) || (type == ARG_UNSIGNED);
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			return type == ARG_DOUBLE;
+		case 's':
+			return type == ARG_STRING;
+		case 'p':
+			// a char pointer is typed as a string, its address is written
+			return (type == ARG_POINTER) || (type == ARG_STRING);
+		default:
+			return false;
+		}
+	}
+
+
+	// internal conversion of one specification, taking its arguments from the typed argument list
+	// \return false when an argument is missing, or its type does not suit its specifier
+	template <typename O>
+	inline bool _format_arg_spec(O out, char* buffer, size_t* idx, size_t maxlen, const spec_type* format_spec, const arg_type* args, size_t count, size_t* next)
+	{
+		spec_type spec = *format_spec;
+		_instrument_spec(&spec);
+
+		// width and precision given as arguments
+		if (spec.flags & FLAGS_WIDTH_ARG) {
+			if ((*next >= count) || !_arg_matches('d', args[*next].type)) {
+				return false;
+			}
+			const arg_type* w = &args[(*next)++];
+			if ((w->type == ARG_SIGNED) && (w->i < 0)) {
+				spec.flags |= FLAGS_LEFT;    // reverse padding
+				spec.width = (unsigned int)(0ULL - w->u);
+			}
+			else {
+				spec.width = (unsigned int)w->u;
+			}
+		}
+		if (spec.flags & FLAGS_PRECISION_ARG) {
+			if ((*next >= count) || !_arg_matches('d', args[*next].type)) {
+				return false;
+			}
+			const arg_type* p = &args[(*next)++];
+			if ((p->type == ARG_SIGNED) && (p->i < 0)) {
+				spec.flags &= ~FLAGS_PRECISION;    // a negative precision is taken as omitted
+			}
+			else {
+				spec.precision = (unsigned int)p->u;
+			}
+		}
+
+		if (!_takes_arg(spec.specifier)) {
+			if (spec.specifier) {
+				// '%' and the unknown specifiers are written out as they are
+				out(&spec.specifier, 1U, buffer, (*idx)++, maxlen);
+			}
+			return true;
+		}
+		if ((*next >= count) || !_arg_matches(spec.specifier, args[*next].type)) {
+			return false;
+		}
+		const arg_type* arg = &args[(*next)++];
+		if ((spec.specifier == 'p') && (arg->type == ARG_STRING) && (arg->length != (size_t)-1)) {
+			// a string view, or a string copied by log_defer(), has no address of its own to write
+			return false;
+		}
+
+		switch (spec.specifier) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'b': {
+			// the length modifiers are not needed, the real size of the argument is known
+			spec.flags &= ~(FLAGS_CHAR | FLAGS_SHORT | FLAGS_LONG | FLAGS_LONG_LONG);
+			if (arg->size > sizeof(long)) {
+				spec.flags |= FLAGS_LONG_LONG;
+			}
+			if ((arg->type == ARG_SIGNED) && ((spec.specifier == 'd') || (spec.specifier == 'i'))) {
+				*idx = _format_integer(out, buffer, *idx, maxlen, &spec, arg->i < 0 ? 0ULL - arg->u : arg->u, arg->i < 0);
+			}
+			else {
+				// unsigned conversions of signed values use the bits of the argument, at its size
+				const unsigned long long mask = arg->size < sizeof(unsigned long long) ? (1ULL << (arg->size * 8U)) - 1U : ~0ULL;
+				*idx = _format_integer(out, buffer, *idx, maxlen, &spec, arg->u & mask, false);
+			}
+			return true;
+		}
+#if defined(PRINTF_SUPPORT_FLOAT)
+		case 'f':
+		case 'F':
+		case 'a':
+		case 'A':
+#if defined(PRINTF_SUPPORT_EXPONENTIAL)
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+#endif  // PRINTF_SUPPORT_EXPONENTIAL
+			*idx = _format_float(out, buffer, *idx, maxlen, &spec, arg->d);
+			return true;
+#endif  // PRINTF_SUPPORT_FLOAT
+		case 'c':
+			*idx = _format_char(out, buffer, *idx, maxlen, &spec, (char)arg->u);
+			return true;
+		case 's':
+			if (!arg->s && (arg->length == (size_t)-1)) {
+				// a null char pointer, the way glibc writes it
+				*idx = _format_string(out, buffer, *idx, maxlen, &spec, "(null)", (size_t)-1);
+				return true;
+			}
+			*idx = _format_string(out, buffer, *idx, maxlen, &spec, arg->s, arg->length);
+			return true;
+		case 'p':
+			*idx = _format_pointer(out, buffer, *idx, maxlen, &spec, (uintptr_t)arg->p);
+			return true;
+		default:
+			return true;
+		}
+	}
+
+
+	// internal format of the typed argument list, parsing the format as it goes
+	// the output is not 0 terminated
+	// \return The number of characters, or -1 when an argument is missing or does not suit its specifier
+	template <typename O>
+	inline int _vformat(O out, char* buffer, const size_t maxlen, const char* format, const arg_type* args, size_t count)
+	{
+		size_t idx = 0U, next = 0U;
+		spec_type spec;
+
+		while (*format) {
+			if (*format != '%') {
+				const char* literal = format;
+				format = _find_specifier(format);
+				out(literal, (size_t)(format - literal), buffer, idx, maxlen);
+				idx += (size_t)(format - literal);
+				continue;
+			}
+			format = _parse_spec(format + 1, &spec);
+			if (!_format_arg_spec(out, buffer, &idx, maxlen, &spec, args, count, &next)) {
+				return -1;
+			}
+		}
+		_instrument_call(out, idx, maxlen);
+		return (int)idx;
+	}
+
+
+	// internal format of the typed argument list, with a compiled format
+	// the output is not 0 terminated
+	// \return The number of characters, or -1 when an argument is missing or does not suit its specifier
+	template <typename O>
+	inline int _vformat_ops(O out, char* buffer, const size_t maxlen, const char* format, const format_op_type* ops, const arg_type* args, size_t count)
+	{
+		size_t idx = 0U, next = 0U;
+
+		for (;; ops++) {
+			if (ops->length) {
+				out(format + ops->offset, ops->length, buffer, idx, maxlen);
+				idx += ops->length;
+			}
+			if (!ops->spec.specifier) {
+				break;
+			}
+			if (!_format_arg_spec(out, buffer, &idx, maxlen, &ops->spec, args, count, &next)) {
+				return -1;
+			}
+		}
+		_instrument_call(out, idx, maxlen);
+		return (int)idx;
+	}
+
+
+	// the argument type of T
+	template <typename T>
+	constexpr unsigned int _arg_type()
+	{
+		using D = std::decay_t<T>;
+		if constexpr (std::is_integral_v<D>) {
+			return std::is_signed_v<D> ? ARG_SIGNED : ARG_UNSIGNED;
+		}
+		else if constexpr (std::is_enum_v<D>) {
+			return _arg_type<std::underlying_type_t<D>>();
+		}
+		else if constexpr (std::is_floating_point_v<D>) {
+			return ARG_DOUBLE;
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*> || std::is_convertible_v<const T&, std::string_view>) {
+			return ARG_STRING;
+		}
+		else if constexpr (std::is_pointer_v<D> || std::is_null_pointer_v<D>) {
+			return ARG_POINTER;
+		}
+		else {
+			return 0U;
+		}
+	}
+
+
+	template <typename T>
+	inline arg_type _make_arg(const T& value)
+	{
+		using D = std::decay_t<T>;
+		static_assert(_arg_type<T>() != 0U, "format(): the argument type is not an integer, floating point, string or pointer type");
+		arg_type arg{};
+		arg.type = _arg_type<T>();
+		if constexpr (std::is_integral_v<D> || std::is_enum_v<D>) {
+			arg.size = sizeof(D);
+			if (arg.type == ARG_SIGNED) {
+				arg.i = (long long)value;
+			}
+			else {
+				arg.u = (unsigned long long)value;
+			}
+		}
+		else if constexpr (std::is_floating_point_v<D>) {
+			arg.d = (double)value;
+		}
+		else if constexpr (std::is_convertible_v<const T&, const char*>) {
+			arg.s = value;
+			arg.length = (size_t)-1;
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+			const std::string_view view = value;
+			arg.s = view.data();
+			arg.length = view.size();
+		}
+		else {
+			arg.p = (const void*)value;
+		}
+		return arg;
+	}
+
+
+	// compile time check of the arguments of F against its conversions
+	// copied: the strings are copied (log_defer()), a char pointer has no address for %p then
+	template <typename F, typename... Args>
+	constexpr bool _args_match(bool copied = false)
+	{
+		constexpr unsigned int types[sizeof...(Args) + 1U] = { _arg_type<Args>()... };
+		size_t next = 0U;
+		for (const format_op_type& op : compiled_format<F>::ops.op) {
+			if (op.spec.flags & FLAGS_WIDTH_ARG) {
+				if ((next >= sizeof...(Args)) || !_arg_matches('d', types[next++])) {
+					return false;
+				}
+			}
+			if (op.spec.flags & FLAGS_PRECISION_ARG) {
+				if ((next >= sizeof...(Args)) || !_arg_matches('d', types[next++])) {
+					return false;
+				}
+			}
+			if (_takes_arg(op.spec.specifier)) {
+				if ((next >= sizeof...(Args)) || !_arg_matches(op.spec.specifier, types[next])) {
+					return false;
+				}
+				if (copied && (op.spec.specifier == 'p') && (types[next] == ARG_STRING)) {
+					return false;
+				}
+				next++;
+			}
+		}
+		return true;
+	}
+
+
+	// block output to a callable taking (const char* data, size_t len), inlined
+	template <typename S>
+	struct out_callable_sink_type {
+		void operator()(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen) const
+		{
+			(void)idx; (void)maxlen;
+			(*(S*)buffer)(data, len);
+		}
+	};
+
+
+	template <typename F, typename O>
+	inline int _format_args(O out, char* buffer, size_t maxlen, const F& format, const arg_type* args, size_t count)
+	{
+		if constexpr (is_format_string_v<F>) {
+			return _vformat_ops(out, buffer, maxlen, compiled_format<F>::format, compiled_format<F>::ops.op, args, count);
+		}
+		else {
+			return _vformat(out, buffer, maxlen, format, args, count);
+		}
+	}
+
+
+	// growable output, staged on the stack until it outgrows the stage
+	// C is the container appended to, or void for a malloc() buffer
+	template <typename C>
+	struct out_grow_type {
+		C* container;
+		size_t base;    // container size before the output
+		char* data;     // the stage, or the storage after it
+		size_t size;    // size of data
+		bool failed;    // the storage could not grow
+		char stage[PRINTF_GROW_STAGE_SIZE];
+	};
+
+
+	// internal resize of the container
+	// \return false when it throws, std::bad_alloc must not unwind through the extern "C" engine
+	template <typename C>
+	inline bool _grow_resize(C* container, size_t size)
+	{
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+		try {
+			container->resize(size);
+		}
+		catch (...) {
+			return false;
+		}
+#else
+		container->resize(size);
+#endif
+		return true;
+	}
+
+
+	// internal growth of the output storage to at least 'need' characters, doubling it
+	template <typename C>
+	inline bool _grow(out_grow_type<C>* grow, size_t need)
+	{
+		const size_t size = (grow->size * 2U > need) ? grow->size * 2U : need;
+		if constexpr (std::is_void_v<C>) {
+			char* data = (char*)std::realloc((grow->data == grow->stage) ? nullptr : grow->data, size);
+			if (!data) {
+				grow->failed = true;
+				return false;
+			}
+			if (grow->data == grow->stage) {
+				std::memcpy(data, grow->stage, grow->size);
+			}
+			grow->data = data;
+		}
+		else {
+			if (!_grow_resize(grow->container, grow->base + size)) {
+				grow->failed = true;
+				return false;
+			}
+			if (grow->data == grow->stage) {
+				std::memcpy(grow->container->data() + grow->base, grow->stage, grow->size);
+			}
+			grow->data = grow->container->data() + grow->base;
+		}
+		grow->size = size;
+		return true;
+	}
+
+
+	// internal growable block output
+	template <typename C>
+	inline void _out_grow_block(const char* data, size_t len, void* buffer, size_t idx, size_t maxlen)
+	{
+		(void)maxlen;
+		out_grow_type<C>* grow = (out_grow_type<C>*)buffer;
+		if ((idx + len > grow->size) && (grow->failed || !_grow(grow, idx + len))) {
+			return;
+		}
+		std::memcpy(grow->data + idx, data, len);
+	}
+
+
+	// internal start of a growable output, appending to container
+	template <typename C>
+	inline void _grow_start(out_grow_type<C>* grow, C* container)
+	{
+		grow->container = container;
+		grow->base = 0U;
+		if constexpr (!std::is_void_v<C>) {
+			grow->base = container->size();
+		}
+		grow->data = grow->stage;
+		grow->size = PRINTF_GROW_STAGE_SIZE;
+		grow->failed = false;
+	}
+
+
+	// internal end of a growable output of 'len' characters, moving the stage to the storage
+	// a container which could not grow is left as it was, and grow->failed is set
+	// \return The malloc() buffer, for C void
+	template <typename C>
+	inline char* _grow_finish(out_grow_type<C>* grow, int len)
+	{
+		if constexpr (std::is_void_v<C>) {
+			if (grow->failed || (len < 0)) {
+				if (grow->data != grow->stage) {
+					std::free(grow->data);
+				}
+				return nullptr;
+			}
+			if (grow->data == grow->stage) {
+				char* data = (char*)std::malloc((size_t)len + 1U);
+				if (data) {
+					std::memcpy(data, grow->stage, (size_t)len + 1U);
+				}
+				return data;
+			}
+			return grow->data;
+		}
+		else {
+			const size_t size = (len > 0) ? (size_t)len : 0U;
+			if (grow->failed || !_grow_resize(grow->container, grow->base + size)) {
+				grow->failed = true;
+				grow->container->resize(grow->base);
+				return nullptr;
+			}
+			if (grow->data == grow->stage) {
+				std::memcpy(grow->container->data() + grow->base, grow->stage, size);
+			}
+			return nullptr;
+		}
+	}
+
+
+	// internal vsnprintf appending to a growable container
+	// \return The number of characters appended, -1 when the container could not grow
+	template <typename C>
+	inline int _vformat_to(C* container, const char* format, va_list va)
+	{
+		out_grow_type<C> grow;
+		_grow_start(&grow, container);
+		const int ret = _vsnprintf_block(_out_grow_block<C>, (char*)&grow, (size_t)-1, format, va);
+		_grow_finish(&grow, ret);
+		return grow.failed ? -1 : ret;
+	}
+
+
+	// internal vsnprintf, writing to the character output function
+	// kept for custom character sinks, which are adapted to the block output
+	PRINTF_EXTERN_C  inline int _vsnprintf(out_fct_type out, char* buffer, const size_t maxlen, const char* format, va_list va)
+	{
+		if (!buffer) {
+			return _vsnprintf_block(_out_null_block, buffer, maxlen, format, va);
+		}
+		out_block_wrap_type out_block_wrap = { out, buffer };
+		return _vsnprintf_block(_out_block_wrap, (char*)&out_block_wrap, maxlen, format, va);
+	}
+
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace inner 
+///////////////////////////////////////////////////////////////////////////////
+
+
+	PRINTF_EXTERN_C inline int printf(const char* format, ...)
+	{
+		using namespace inner;
+		va_list va;
+		va_start(va, format);
+#if defined(PRINTF_USER_DEFINED_PUTCHAR)
+		char buffer[1];
+		const int ret = _vsnprintf_block(_out_char_block, buffer, (size_t)-1, format, va);
+#else
+		// one hand over to stdio per call, instead of one per character
+		out_stdout_type* stage = _stdout_buffer();
+		const int ret = _vsnprintf_block(_out_stdout_block, (char*)stage, (size_t)-1, format, va);
+		_stdout_flush(stage);
+#endif
+		va_end(va);
+		return ret;
+	}
+
+
+	PRINTF_EXTERN_C inline int sprintf(char* buffer, const char* format, ...)
+	{
+		using namespace inner;
+		va_list va;
+		va_start(va, format);
+		const int ret = _vsnprintf_block(_out_buffer_block, buffer, (size_t)-1, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	PRINTF_EXTERN_C  inline int snprintf(char* buffer, size_t count, const char* format, ...)
+	{
+		using namespace inner;
+		va_list va;
+		va_start(va, format);
+		const int ret = _vsnprintf_block(_out_buffer_block, buffer, count, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	PRINTF_EXTERN_C  inline int vsnprintf(char* buffer, size_t count, const char* format, va_list va)
+	{
+		return inner::_vsnprintf_block(inner::_out_buffer_block, buffer, count, format, va);
+	}
+
+
+	// vsnprintf() through the format cache, the format is compiled at its first use and reused after
+	// formats are told apart by their address only, so the format must never change its content,
+	// e.g. a literal; a format built in a reused buffer must go through vsnprintf()
+	PRINTF_EXTERN_C inline int vsnprintf_cached(char* buffer, size_t count, const char* format, va_list va)
+	{
+		using namespace inner;
+		return _with_sink(_out_buffer_block, buffer, count, [&](auto sink) {
+			return _vsnprintf_cached(sink, buffer, count, format, va);
+		});
+	}
+
+
+	PRINTF_EXTERN_C inline int snprintf_cached(char* buffer, size_t count, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const int ret = vsnprintf_cached(buffer, count, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	typedef struct {
+		size_t written;    // characters written, without the terminating \0
+		bool truncated;    // the output did not fit the buffer
+	} snprintf_trunc_type;
+
+
+	// snprintf() stopping at the first character which does not fit, for output which is cut
+	// anyway, e.g. fixed width columns; the length the whole output would have is not known
+	PRINTF_EXTERN_C inline snprintf_trunc_type vsnprintf_trunc(char* buffer, size_t count, const char* format, va_list va)
+	{
+		if (!buffer || !count) {
+			// nothing can be stored, any output is cut, and it stops at its first character
+			const size_t idx = (size_t)inner::_vsnprintf_stop(nullptr, 0U, format, va);
+			return { 0U, idx > 0U };
+		}
+		const size_t idx = (size_t)inner::_vsnprintf_stop(buffer, count, format, va);
+		return { idx < count ? idx : count - 1U, idx >= count };
+	}
+
+
+	PRINTF_EXTERN_C inline snprintf_trunc_type snprintf_trunc(char* buffer, size_t count, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const snprintf_trunc_type ret = vsnprintf_trunc(buffer, count, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	PRINTF_EXTERN_C inline int fctprintf(void(*out)(char character, void* arg), void* arg, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const inner::out_fct_wrap_type out_fct_wrap = { out, arg };
+		const int ret = inner::_vsnprintf_block(inner::_out_fct_block, (char*)&out_fct_wrap, (size_t)-1, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	// fctprintf with a block output function, it gets the output in blocks of up to
+	// PRINTF_FCT_BUFFER_SIZE characters, without the terminating 0
+	PRINTF_EXTERN_C inline int fctprintf_block(void(*out)(const char* data, size_t len, void* arg), void* arg, const char* format, ...)
+	{
+		using namespace inner;
+		va_list va;
+		va_start(va, format);
+		out_fct_stage_type stage;
+		stage.fct = out;
+		stage.arg = arg;
+		stage.len = 0U;
+		const int ret = _vsnprintf_block(_out_fct_stage_block, (char*)&stage, (size_t)-1, format, va);
+		va_end(va);
+		// the terminating 0 is the last character staged
+		stage.len--;
+		_fct_stage_flush(&stage);
+		return ret;
+	}
+
+
+	// append the output to the string or vector, in one pass, growing it as needed
+	// \return The number of characters appended, -1 when it could not grow, it is then left as it was
+	inline int vformat_to(std::string& out, const char* format, va_list va)
+	{
+		return inner::_vformat_to(&out, format, va);
+	}
+
+
+	inline int vformat_to(std::vector<char>& out, const char* format, va_list va)
+	{
+		return inner::_vformat_to(&out, format, va);
+	}
+
+
+	inline int format_to(std::string& out, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const int ret = inner::_vformat_to(&out, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	inline int format_to(std::vector<char>& out, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const int ret = inner::_vformat_to(&out, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+	// the output in a new 0 terminated buffer at *strp, to be released with free()
+	// \return The number of characters, or -1 when the buffer could not be allocated
+	PRINTF_EXTERN_C inline int vasprintf(char** strp, const char* format, va_list va)
+	{
+		using namespace inner;
+		out_grow_type<void> grow;
+		_grow_start<void>(&grow, nullptr);
+		const int ret = _vsnprintf_block(_out_grow_block<void>, (char*)&grow, (size_t)-1, format, va);
+		*strp = _grow_finish(&grow, ret);
+		return *strp ? ret : -1;
+	}
+
+
+	PRINTF_EXTERN_C inline int asprintf(char** strp, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const int ret = vasprintf(strp, format, va);
+		va_end(va);
+		return ret;
+	}
+
+
+#if defined(PRINTF_SUPPORT_FORMAT_ARENA)
+	// block of a format arena, taken from its memory resource, the strings follow it
+	typedef struct arena_block_type {
+		struct arena_block_type* next;
+		size_t size;
+	} arena_block_type;
+
+
+	typedef struct {
+		size_t strings;    // strings formatted
+		size_t bytes;      // characters formatted, without the terminating 0s
+		size_t blocks;     // blocks taken from the memory resource
+		size_t refills;    // strings formatted twice, as they did not fit the current block
+		size_t failures;   // strings which did not fit, with no memory resource to grow
+	} format_arena_stats_type;
+
+
+	// format arena, a bump allocator for formatted strings
+	// the strings are kept in the caller's buffer, then in blocks taken from the memory
+	// resource, e.g. a std::pmr::monotonic_buffer_resource; they all live until arena_release()
+	typedef struct {
+		char* buffer;                           // the caller's buffer
+		size_t buffer_size;
+		std::pmr::memory_resource* resource;    // nullptr, to use the buffer only
+		arena_block_type* blocks;               // the blocks taken, the current one first
+		char* data;                             // the current buffer or block
+		size_t size;
+		size_t used;
+		format_arena_stats_type stats;
+	} format_arena_type;
+
+
+	// arena over the caller's buffer, growing from resource when it is not nullptr
+	inline void arena_init(format_arena_type* arena, char* buffer, size_t size, std::pmr::memory_resource* resource = nullptr)
+	{
+		arena->buffer = buffer;
+		arena->buffer_size = buffer ? size : 0U;
+		arena->resource = resource;
+		arena->blocks = nullptr;
+		arena->data = arena->buffer;
+		arena->size = arena->buffer_size;
+		arena->used = 0U;
+		arena->stats = format_arena_stats_type{};
+	}
+
+
+	// release all strings of the arena, and return its blocks to the memory resource
+	inline void arena_release(format_arena_type* arena)
+	{
+		while (arena->blocks) {
+			arena_block_type* block = arena->blocks;
+			arena->blocks = block->next;
+			arena->resource->deallocate(block, block->size, alignof(arena_block_type));
+		}
+		arena->data = arena->buffer;
+		arena->size = arena->buffer_size;
+		arena->used = 0U;
+	}
+
+
+	// format into the arena
+	// \return The 0 terminated string, it lives until arena_release(); empty when the string
+	//         does not fit and the arena has no memory resource, the resource's exception
+	//         when it cannot allocate
+	inline std::string_view arena_vprintf(format_arena_type* arena, const char* format, va_list va)
+	{
+		using namespace inner;
+		char* p = arena->data + arena->used;
+		va_list args;
+		va_copy(args, va);
+		const int ret = _vsnprintf_block(_out_buffer_block, arena->data ? p : nullptr, arena->size - arena->used, format, args);
+		va_end(args);
+		if (ret < 0) {
+			return std::string_view();
+		}
+
+		const size_t need = (size_t)ret + 1U;
+		if (need > arena->size - arena->used) {
+			// did not fit, format it again into a new block
+			if (!arena->resource) {
+				arena->stats.failures++;
+				return std::string_view();
+			}
+			const size_t size = sizeof(arena_block_type) + (need > PRINTF_ARENA_BLOCK_SIZE ? need : PRINTF_ARENA_BLOCK_SIZE);
+			arena_block_type* block = (arena_block_type*)arena->resource->allocate(size, alignof(arena_block_type));
+			block->next = arena->blocks;
+			block->size = size;
+			arena->blocks = block;
+			arena->data = (char*)(block + 1);
+			arena->size = size - sizeof(arena_block_type);
+			arena->used = 0U;
+			p = arena->data;
+			va_copy(args, va);
+			_vsnprintf_block(_out_buffer_block, p, arena->size, format, args);
+			va_end(args);
+			arena->stats.blocks++;
+			arena->stats.refills++;
+		}
+
+		arena->used += need;
+		arena->stats.strings++;
+		arena->stats.bytes += (size_t)ret;
+		return std::string_view(p, (size_t)ret);
+	}
+
+
+	inline std::string_view arena_printf(format_arena_type* arena, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const std::string_view ret = arena_vprintf(arena, format, va);
+		va_end(va);
+		return ret;
+	}
+#endif  // PRINTF_SUPPORT_FORMAT_ARENA
+
+
+#if defined(PRINTF_SUPPORT_LOG_RING)
+	// what log_printf() does when the ring is full
+	typedef enum {
+		LOG_POLICY_BLOCK,        // wait for the drain to free a slot
+		LOG_POLICY_DROP,         // drop the message, and return -1
+		LOG_POLICY_OVERWRITE     // drop the oldest message in the ring instead
+	} log_policy_type;
+
+
+	// log ring slot, holding one message, or the record of a deferred one
+	typedef struct {
+		std::atomic<size_t> sequence;   // the position it is free for, or + 1 when it holds a message
+		size_t len;
+		bool deferred;
+		char data[inner::PRINTF_LOG_SLOT_SIZE];
+	} log_slot_type;
+
+
+	// deferred message record, the format and its captured arguments follow in the slot,
+	// each as its type, its size, and its 8 bytes, or for a string as its type, 1 when it is
+	// a null char pointer, a 2 byte length and the characters
+	typedef struct {
+		const char* format;
+		const inner::format_op_type* ops;    // of a PRINTF_FMT format, nullptr otherwise
+		size_t count;
+	} log_record_type;
+
+
+	// binary log file header, the entries follow it:
+	//   'F', 2 byte id, 2 byte length, the characters   a format, before the first record using it
+	//   'R', 2 byte id, 1 byte count, the arguments      a deferred message, each argument as its
+	//                                                    type, its size and the bytes of its value
+	//                                                    (as many as its size, 8 for the others),
+	//                                                    or a 2 byte length and the characters
+	//                                                    (PRINTF_LOG_NULL_STRING and none for a
+	//                                                    null char pointer)
+	//   'T', 2 byte length, the characters               a message formatted by log_printf()
+	// all in the byte order of the writer, which order tells
+	typedef struct {
+		char magic[8];        // "printf++"
+		uint32_t order;       // 0x01020304
+		uint32_t version;     // 1
+	} log_file_header_type;
+
+
+	typedef struct {
+		size_t messages;      // messages queued
+		size_t bytes;         // characters written out
+		size_t writes;        // writes to the file descriptor
+		size_t drops;         // messages dropped, LOG_POLICY_DROP
+		size_t overwrites;    // oldest messages dropped, LOG_POLICY_OVERWRITE
+		size_t truncated;     // messages cut to the slot size, or deferred strings cut
+		size_t invalid;       // deferred messages whose arguments did not suit the format
+		size_t high_water;    // most slots in use at once
+	} log_stats_type;
+
+
+	// log ring, a bounded lock-free queue of slots (D. Vyukov's), the producers format into
+	// the slot they claim, and one drain writes the messages out in large blocks
+	typedef struct {
+		alignas(64) std::atomic<size_t> head;     // next position to claim, producers
+		alignas(64) std::atomic<size_t> tail;     // next position to drain
+		alignas(64) log_slot_type* slots;
+		size_t mask;
+		int fd;
+		log_policy_type policy;
+		bool binary;                              // log_start_binary()
+		const char* formats[inner::PRINTF_LOG_FORMATS];    // the binary log dictionary, by id
+		std::atomic<bool> running;
+		std::atomic<bool> sleeping;
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::atomic<size_t> bytes;
+		std::atomic<size_t> writes;
+		std::atomic<size_t> drops;
+		std::atomic<size_t> overwrites;
+		std::atomic<size_t> truncated;
+		std::atomic<size_t> invalid;
+		std::atomic<size_t> high_water;
+		char batch[inner::PRINTF_LOG_WRITE_SIZE];
+	} log_ring_type;
+
+
+	namespace inner {
+		// internal write of a block to the log file descriptor
+		inline void _log_write(log_ring_type* ring, const char* data, size_t len)
+		{
+			ring->writes.fetch_add(1U, std::memory_order_relaxed);
+			ring->bytes.fetch_add(len, std::memory_order_relaxed);
+			while (len) {
+#if defined(_WIN32)
+				const int written = _write(ring->fd, data, (unsigned int)len);
+#else
+				const ssize_t written = ::write(ring->fd, data, len);
+#endif
+				if (written <= 0) {
+					break;
+				}
+				data += written;
+				len -= (size_t)written;
+			}
+		}
+
+
+		// internal claim of the oldest message, nullptr when there is none
+		inline log_slot_type* _log_pop(log_ring_type* ring, size_t* pos)
+		{
+			size_t tail = ring->tail.load(std::memory_order_relaxed);
+			for (;;) {
+				log_slot_type* slot = &ring->slots[tail & ring->mask];
+				const intptr_t diff = (intptr_t)(slot->sequence.load(std::memory_order_acquire) - (tail + 1U));
+				if (diff < 0) {
+					// empty, or the oldest message is still being formatted
+					return nullptr;
+				}
+				if (diff == 0 && ring->tail.compare_exchange_weak(tail, tail + 1U, std::memory_order_relaxed)) {
+					*pos = tail;
+					return slot;
+				}
+				if (diff > 0) {
+					tail = ring->tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+
+		// internal release of a popped slot, for the position a lap later
+		inline void _log_free(log_ring_type* ring, log_slot_type* slot, size_t pos)
+		{
+			slot->sequence.store(pos + ring->mask + 1U, std::memory_order_release);
+		}
+
+
+		// internal argument list of a deferred message record
+		inline void _log_args(const log_slot_type* slot, log_record_type* record, arg_type* args)
+		{
+			std::memcpy(record, slot->data, sizeof(*record));
+			const char* p = slot->data + sizeof(*record);
+			for (size_t i = 0U; i < record->count; ++i) {
+				args[i] = arg_type{};
+				args[i].type = (unsigned char)*p++;
+				args[i].size = (unsigned char)*p++;
+				if (args[i].type == ARG_STRING) {
+					uint16_t length;
+					std::memcpy(&length, p, sizeof(length));
+					if (args[i].size) {
+						// a null char pointer, written as format() writes it
+						args[i].size = 0U;
+						args[i].s = nullptr;
+						args[i].length = (size_t)-1;
+					}
+					else {
+						args[i].s = p + sizeof(length);
+						args[i].length = length;
+					}
+					p += sizeof(length) + length;
+				}
+				else {
+					std::memcpy(&args[i].u, p, sizeof(args[i].u));
+					p += sizeof(args[i].u);
+				}
+			}
+		}
+
+
+		// internal render of a deferred message record, cut to the slot size like the others
+		// \return The number of characters
+		inline size_t _log_render(log_ring_type* ring, const log_slot_type* slot, char* buffer)
+		{
+			log_record_type record;
+			arg_type args[PRINTF_LOG_DEFER_ARGS];
+			_log_args(slot, &record, args);
+
+			const int ret = record.ops ?
+				_vformat_ops(out_buffer_sink_type{}, buffer, PRINTF_LOG_SLOT_SIZE - 1U, record.format, record.ops, args, record.count) :
+				_vformat(out_buffer_sink_type{}, buffer, PRINTF_LOG_SLOT_SIZE - 1U, record.format, args, record.count);
+			if (ret < 0) {
+				ring->invalid.fetch_add(1U, std::memory_order_relaxed);
+				return 0U;
+			}
+			if ((size_t)ret >= PRINTF_LOG_SLOT_SIZE) {
+				ring->truncated.fetch_add(1U, std::memory_order_relaxed);
+				return PRINTF_LOG_SLOT_SIZE - 1U;
+			}
+			return (size_t)ret;
+		}
+
+
+		// internal staging of a block into the drain's batch, written out when full
+		inline void _log_put(log_ring_type* ring, size_t* len, const void* data, size_t size)
+		{
+			if (*len + size > PRINTF_LOG_WRITE_SIZE) {
+				_log_write(ring, ring->batch, *len);
+				*len = 0U;
+			}
+			if (size > PRINTF_LOG_WRITE_SIZE) {
+				_log_write(ring, (const char*)data, size);
+				return;
+			}
+			std::memcpy(ring->batch + *len, data, size);
+			*len += size;
+		}
+
+
+		// internal binary log id of a format, its dictionary entry is written out the first
+		// time it is seen; (size_t)-1 when the dictionary is full
+		inline size_t _log_format_id(log_ring_type* ring, const char* format, size_t* len)
+		{
+			// formats are told apart by their address, like in the format cache
+			size_t id = (size_t)(((uintptr_t)format >> 3U) * 0x9E3779B97F4A7C15ULL >> 32U);
+			for (size_t i = 0U; i < PRINTF_LOG_FORMATS; ++i, ++id) {
+				id &= PRINTF_LOG_FORMATS - 1U;
+				if (ring->formats[id] == format) {
+					return id;
+				}
+				if (!ring->formats[id]) {
+					const size_t length = std::strlen(format);
+					if (length > 0xFFFFU) {
+						return (size_t)-1;
+					}
+					ring->formats[id] = format;
+					char entry[5];
+					entry[0] = 'F';
+					const uint16_t id16 = (uint16_t)id, length16 = (uint16_t)length;
+					std::memcpy(entry + 1, &id16, sizeof(id16));
+					std::memcpy(entry + 3, &length16, sizeof(length16));
+					_log_put(ring, len, entry, sizeof(entry));
+					_log_put(ring, len, format, length);
+					return id;
+				}
+			}
+			return (size_t)-1;
+		}
+
+
+		// internal binary log entry of a message
+		inline void _log_binary(log_ring_type* ring, const log_slot_type* slot, size_t* len)
+		{
+			char entry[PRINTF_LOG_SLOT_SIZE + 8U];
+			char* p = entry;
+			if (slot->deferred) {
+				log_record_type record;
+				arg_type args[PRINTF_LOG_DEFER_ARGS];
+				_log_args(slot, &record, args);
+				const size_t id = _log_format_id(ring, record.format, len);
+				if (id != (size_t)-1) {
+					const uint16_t id16 = (uint16_t)id;
+					*p++ = 'R';
+					std::memcpy(p, &id16, sizeof(id16));
+					p += sizeof(id16);
+					*p++ = (char)record.count;
+					for (size_t i = 0U; i < record.count; ++i) {
+						*p++ = (char)args[i].type;
+						if (args[i].type == ARG_STRING) {
+							const uint16_t length = args[i].s ? (uint16_t)args[i].length : PRINTF_LOG_NULL_STRING;
+							std::memcpy(p, &length, sizeof(length));
+							if (args[i].s) {
+								std::memcpy(p + sizeof(length), args[i].s, length);
+								p += length;
+							}
+							p += sizeof(length);
+						}
+						else {
+							// integers take their own size, little or big end first as the writer
+							const unsigned int size = args[i].size ? args[i].size : (unsigned int)sizeof(args[i].u);
+							*p++ = (char)size;
+							const unsigned long long value = args[i].u;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+							std::memcpy(p, (const char*)&value + sizeof(value) - size, size);
+#else
+							std::memcpy(p, &value, size);
+#endif
+							p += size;
+						}
+					}
+					_log_put(ring, len, entry, (size_t)(p - entry));
+					return;
+				}
+			}
+
+			// formatted messages, and the deferred ones past the dictionary, as text
+			const size_t size = slot->deferred ? _log_render(ring, slot, entry + 3) : slot->len;
+			if (!slot->deferred) {
+				std::memcpy(entry + 3, slot->data, size);
+			}
+			const uint16_t length = (uint16_t)size;
+			entry[0] = 'T';
+			std::memcpy(entry + 1, &length, sizeof(length));
+			_log_put(ring, len, entry, size + 3U);
+		}
+
+
+		// internal drain, writes the queued messages out in blocks
+		// \return The number of messages written
+		inline size_t _log_drain(log_ring_type* ring)
+		{
+			size_t count = 0U, len = 0U, pos;
+			while (log_slot_type* slot = _log_pop(ring, &pos)) {
+				if (ring->binary) {
+					_log_binary(ring, slot, &len);
+				}
+				else {
+					if (len + (slot->deferred ? PRINTF_LOG_SLOT_SIZE : slot->len) > PRINTF_LOG_WRITE_SIZE) {
+						_log_write(ring, ring->batch, len);
+						len = 0U;
+					}
+					if (slot->deferred) {
+						len += _log_render(ring, slot, ring->batch + len);
+					}
+					else {
+						std::memcpy(ring->batch + len, slot->data, slot->len);
+						len += slot->len;
+					}
+				}
+				_log_free(ring, slot, pos);
+				count++;
+			}
+			if (len) {
+				_log_write(ring, ring->batch, len);
+			}
+			return count;
 		}
 
-		int whole = (int)value;
-		double tmp = (value - whole) * pow10[prec];
-		unsigned long frac = (unsigned long)tmp;
-		diff = tmp - frac;
 
-		if (diff > 0.5) {
-			++frac;
-			// handle rollover, e.g. case 0.99 with prec 1 is 1.0
-			if (frac >= pow10[prec]) {
-				frac = 0;
-				++whole;
+		// internal drain thread, sleeps when the ring is empty
+		inline void _log_drain_thread(log_ring_type* ring)
+		{
+			while (ring->running.load(std::memory_order_acquire)) {
+				if (_log_drain(ring)) {
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(ring->mutex);
+				ring->sleeping.store(true);
+				const size_t tail = ring->tail.load(std::memory_order_relaxed);
+				if (ring->slots[tail & ring->mask].sequence.load() != tail + 1U && ring->running.load()) {
+					ring->wake.wait_for(lock, std::chrono::milliseconds(PRINTF_LOG_IDLE_WAIT));
+				}
+				ring->sleeping.store(false, std::memory_order_relaxed);
 			}
-		}
-		else if ((diff == 0.5) && ((frac == 0U) || (frac & 1U))) {
-			// if halfway, round up if odd, OR if last digit is 0
-			++frac;
+			_log_drain(ring);
 		}
 
-		// TBD: for very large numbers switch back to native sprintf for exponentials. Anyone want to write code to replace this?
-		// Normal printf behavior is to print EVERY whole number digit which can be 100s of characters overflowing your buffers == bad
-		if (value > thres_max) {
-			return 0U;
-		}
 
-		if (prec == 0U) {
-			diff = value - (double)whole;
-			if (diff > 0.5) {
-				// greater than 0.5, round up, e.g. 1.6 -> 2
-				++whole;
-			}
-			else if ((diff == 0.5) && (whole & 1)) {
-				// exactly 0.5 and ODD, then round up
-				// 1.5 -> 2, but 2.5 -> 2
-				++whole;
+		// internal full ring, as the policy says
+		// \return false when the message is dropped
+		inline bool _log_full(log_ring_type* ring)
+		{
+			size_t pos;
+			switch (ring->policy) {
+				case LOG_POLICY_DROP:
+					ring->drops.fetch_add(1U, std::memory_order_relaxed);
+					return false;
+				case LOG_POLICY_OVERWRITE:
+					if (log_slot_type* slot = _log_pop(ring, &pos)) {
+						_log_free(ring, slot, pos);
+						ring->overwrites.fetch_add(1U, std::memory_order_relaxed);
+						return true;
+					}
+					break;
+				default:
+					break;
 			}
+			std::this_thread::yield();
+			return true;
 		}
-		else {
-			unsigned int count = prec;
-			// now do fractional part, as an unsigned number
-			while (len < PRINTF_FTOA_BUFFER_SIZE) {
-				--count;
-				buf[len++] = (char)(48U + (frac % 10U));
-				if (!(frac /= 10U)) {
-					break;
+
+
+		// internal claim of the next slot, nullptr when the message is dropped
+		inline log_slot_type* _log_claim(log_ring_type* ring, size_t* pos)
+		{
+			size_t head = ring->head.load(std::memory_order_relaxed);
+			for (;;) {
+				log_slot_type* slot = &ring->slots[head & ring->mask];
+				const intptr_t diff = (intptr_t)(slot->sequence.load(std::memory_order_acquire) - head);
+				if (diff == 0) {
+					if (ring->head.compare_exchange_weak(head, head + 1U, std::memory_order_relaxed)) {
+						*pos = head;
+						return slot;
+					}
+				}
+				else if (diff < 0) {
+					// a lap ahead of the drain, the ring is full
+					if (!_log_full(ring)) {
+						return nullptr;
+					}
+					head = ring->head.load(std::memory_order_relaxed);
+				}
+				else {
+					head = ring->head.load(std::memory_order_relaxed);
 				}
 			}
-			// add extra 0s
-			while ((len < PRINTF_FTOA_BUFFER_SIZE) && (count-- > 0U)) {
-				buf[len++] = '0';
+		}
+
+
+		// internal hand over of a claimed slot to the drain
+		inline void _log_publish(log_ring_type* ring, log_slot_type* slot, size_t pos)
+		{
+			slot->sequence.store(pos + 1U);
+
+			const size_t used = pos + 1U - ring->tail.load(std::memory_order_relaxed);
+			size_t high = ring->high_water.load(std::memory_order_relaxed);
+			while (used > high && used <= ring->mask + 1U && !ring->high_water.compare_exchange_weak(high, used, std::memory_order_relaxed)) {
 			}
-			if (len < PRINTF_FTOA_BUFFER_SIZE) {
-				// add decimal
-				buf[len++] = '.';
+			if (ring->sleeping.load()) {
+				std::lock_guard<std::mutex> lock(ring->mutex);
+				ring->wake.notify_one();
 			}
 		}
 
-		// do whole part, number is reversed
-		while (len < PRINTF_FTOA_BUFFER_SIZE) {
-			buf[len++] = (char)(48 + (whole % 10));
-			if (!(whole /= 10)) {
-				break;
+
+		// internal capture of a deferred argument, its bits or its characters
+		template <typename T>
+		inline char* _log_capture(log_ring_type* ring, char* p, const char* end, const T& value)
+		{
+			const arg_type arg = _make_arg(value);
+			*p++ = (char)arg.type;
+			if (arg.type == ARG_STRING) {
+				// a null char pointer is flagged in place of the size, and has no characters
+				*p++ = (char)(arg.s ? 0 : 1);
+				if (!arg.s) {
+					const uint16_t length = 0U;
+					std::memcpy(p, &length, sizeof(length));
+					return p + sizeof(length);
+				}
+				// copied, the caller's string may be gone when the message is rendered
+				const size_t room = (size_t)(end - p) - sizeof(uint16_t);
+				const size_t full = _strnlen_s(arg.s, arg.length <= room ? arg.length : room + 1U);
+				const uint16_t length = (uint16_t)(full > room ? room : full);
+				if (full > room) {
+					ring->truncated.fetch_add(1U, std::memory_order_relaxed);
+				}
+				std::memcpy(p, &length, sizeof(length));
+				std::memcpy(p + sizeof(length), arg.s, length);
+				return p + sizeof(length) + length;
 			}
+			*p++ = (char)arg.size;
+			std::memcpy(p, &arg.u, sizeof(arg.u));
+			return p + sizeof(arg.u);
 		}
+	}  // namespace inner
 
-		// pad leading zeros
-		while (!(flags & FLAGS_LEFT) && (flags & FLAGS_ZEROPAD) && (len < width) && (len < PRINTF_FTOA_BUFFER_SIZE)) {
-			buf[len++] = '0';
-		}
 
-		// handle sign
-		if ((len == width) && (negative || (flags & FLAGS_PLUS) || (flags & FLAGS_SPACE))) {
-			len--;
-		}
-		if (len < PRINTF_FTOA_BUFFER_SIZE) {
-			if (negative) {
-				buf[len++] = '-';
+	namespace inner {
+		// internal start of a log ring, written out as text or as a binary log
+		inline bool _log_start(log_ring_type* ring, int fd, size_t capacity, log_policy_type policy, bool drain_thread, bool binary)
+		{
+			size_t size = 2U;
+			while (size < capacity) {
+				size <<= 1U;
 			}
-			else if (flags & FLAGS_PLUS) {
-				buf[len++] = '+';  // ignore the space if the '+' exists
+			ring->slots = new (std::nothrow) log_slot_type[size];
+			if (!ring->slots) {
+				return false;
 			}
-			else if (flags & FLAGS_SPACE) {
-				buf[len++] = ' ';
+			for (size_t i = 0U; i < size; ++i) {
+				ring->slots[i].sequence.store(i, std::memory_order_relaxed);
 			}
+			ring->mask = size - 1U;
+			ring->fd = fd;
+			ring->policy = policy;
+			ring->head.store(0U, std::memory_order_relaxed);
+			ring->tail.store(0U, std::memory_order_relaxed);
+			ring->sleeping.store(false, std::memory_order_relaxed);
+			ring->bytes.store(0U, std::memory_order_relaxed);
+			ring->writes.store(0U, std::memory_order_relaxed);
+			ring->drops.store(0U, std::memory_order_relaxed);
+			ring->overwrites.store(0U, std::memory_order_relaxed);
+			ring->truncated.store(0U, std::memory_order_relaxed);
+			ring->invalid.store(0U, std::memory_order_relaxed);
+			ring->high_water.store(0U, std::memory_order_relaxed);
+			ring->binary = binary;
+			std::memset(ring->formats, 0, sizeof(ring->formats));
+			if (binary) {
+				const log_file_header_type header = { { 'p', 'r', 'i', 'n', 't', 'f', '+', '+' }, 0x01020304U, 1U };
+				_log_write(ring, (const char*)&header, sizeof(header));
+			}
+			ring->running.store(drain_thread, std::memory_order_release);
+			if (drain_thread) {
+				ring->thread = std::thread(_log_drain_thread, ring);
+			}
+			return true;
 		}
+	}  // namespace inner
 
-		// pad spaces up to given width
-		if (!(flags & FLAGS_LEFT) && !(flags & FLAGS_ZEROPAD)) {
-			for (size_t i = len; i < width; i++) {
-				out(' ', buffer, idx++, maxlen);
+
+	// start a log ring of capacity slots (rounded up to a power of 2), written out to fd
+	// by a drain thread; without it (drain_thread false) log_drain() writes the messages out,
+	// and LOG_POLICY_BLOCK must not be used
+	// \return false when the slots could not be allocated
+	inline bool log_start(log_ring_type* ring, int fd, size_t capacity, log_policy_type policy = LOG_POLICY_BLOCK, bool drain_thread = true)
+	{
+		return inner::_log_start(ring, fd, capacity, policy, drain_thread, false);
+	}
+
+
+	// log ring written out as a binary log, see log_file_header_type, log_decode() renders it
+	// deferred messages are written with their formats as ids and their arguments as they are
+	inline bool log_start_binary(log_ring_type* ring, int fd, size_t capacity, log_policy_type policy = LOG_POLICY_BLOCK, bool drain_thread = true)
+	{
+		return inner::_log_start(ring, fd, capacity, policy, drain_thread, true);
+	}
+
+
+	// write the queued messages out, on this thread, for a ring without a drain thread
+	// \return The number of messages written
+	inline size_t log_drain(log_ring_type* ring)
+	{
+		return inner::_log_drain(ring);
+	}
+
+
+	// stop the drain thread, write the remaining messages out, and release the slots
+	// the producers must be done before
+	inline void log_stop(log_ring_type* ring)
+	{
+		if (ring->running.exchange(false)) {
+			{
+				std::lock_guard<std::mutex> lock(ring->mutex);
+				ring->wake.notify_one();
 			}
+			ring->thread.join();
 		}
+		inner::_log_drain(ring);
+		delete[] ring->slots;
+		ring->slots = nullptr;
+	}
 
-		// reverse string
-		for (size_t i = 0U; i < len; i++) {
-			out(buf[len - i - 1U], buffer, idx++, maxlen);
+
+	// format a message into the ring, it is cut to PRINTF_LOG_SLOT_SIZE - 1 characters
+	// \return The number of characters for the complete message (like snprintf), or -1 when it is dropped
+	inline int log_vprintf(log_ring_type* ring, const char* format, va_list va)
+	{
+		using namespace inner;
+		size_t pos;
+		log_slot_type* slot = _log_claim(ring, &pos);
+		if (!slot) {
+			return -1;
 		}
 
-		// append pad spaces up to given width
-		if (flags & FLAGS_LEFT) {
-			while (idx < width) {
-				out(' ', buffer, idx++, maxlen);
-			}
+		// format straight into the claimed slot
+		const int ret = _vsnprintf_block(_out_buffer_block, slot->data, PRINTF_LOG_SLOT_SIZE, format, va);
+		slot->deferred = false;
+		slot->len = ret < 0 ? 0U : (size_t)ret;
+		if (slot->len >= PRINTF_LOG_SLOT_SIZE) {
+			slot->len = PRINTF_LOG_SLOT_SIZE - 1U;
+			ring->truncated.fetch_add(1U, std::memory_order_relaxed);
 		}
+		_log_publish(ring, slot, pos);
+		return ret;
+	}
 
-		return idx;
+
+	inline int log_printf(log_ring_type* ring, const char* format, ...)
+	{
+		va_list va;
+		va_start(va, format);
+		const int ret = log_vprintf(ring, format, va);
+		va_end(va);
+		return ret;
 	}
-#endif  // PRINTF_SUPPORT_FLOAT
 
 
-	// internal vsnprintf
-	PRINTF_EXTERN_C  inline int _vsnprintf(out_fct_type out, char* buffer, const size_t maxlen, const char* format, va_list va)
+	// deferred log message, only the format and the bits of the arguments are copied into the
+	// ring, the drain does the conversions; strings are copied, the format must outlive the ring
+	// a char pointer for %p is copied as a string too, pass it as a void pointer (a PRINTF_FMT
+	// format does not compile, a string format counts the message as invalid)
+	// format is a string, or a PRINTF_FMT format whose conversions are checked at compile time
+	// \return 0, or -1 when the message is dropped
+	template <typename F, typename... Args>
+	inline int log_defer(log_ring_type* ring, const F& format, const Args&... args)
 	{
-		unsigned int flags, width, precision, n;
-		size_t idx = 0U;
+		using namespace inner;
+		static_assert(sizeof...(Args) <= PRINTF_LOG_DEFER_ARGS, "log_defer(): too many arguments");
+		static_assert(sizeof(log_record_type) + sizeof...(Args) * (2U + sizeof(unsigned long long)) <= PRINTF_LOG_SLOT_SIZE, "log_defer(): the arguments do not fit a slot");
+		log_record_type record;
+		if constexpr (is_format_string_v<F>) {
+			static_assert(_args_match<F, Args...>(true), "log_defer(): the arguments do not suit the conversions of the format, a char pointer for %p is passed as a void pointer");
+			record = { compiled_format<F>::format, compiled_format<F>::ops.op, sizeof...(Args) };
+		}
+		else {
+			static_assert(std::is_convertible_v<const F&, const char*>, "log_defer(): the format is a string or a PRINTF_FMT format");
+			record = { format, nullptr, sizeof...(Args) };
+		}
 
-		if (!buffer) {
-			// use null output function
-			out = _out_null;
+		size_t pos;
+		log_slot_type* slot = _log_claim(ring, &pos);
+		if (!slot) {
+			return -1;
 		}
+		std::memcpy(slot->data, &record, sizeof(record));
+		char* p = slot->data + sizeof(record);
+		// the strings share what the other arguments leave, in order
+		constexpr size_t reserve = sizeof...(Args) * (2U + sizeof(unsigned long long));
+		const char* end = slot->data + PRINTF_LOG_SLOT_SIZE - reserve;
+		((p = _log_capture(ring, p, end += 2U + sizeof(unsigned long long), args)), ...);
+		slot->deferred = true;
+		slot->len = (size_t)(p - slot->data);
+		_log_publish(ring, slot, pos);
+		return 0;
+	}
 
-		while (*format)
-		{
-			// format specifier?  %[flags][width][.precision][length]
-			if (*format != '%') {
-				// no
-				out(*format, buffer, idx++, maxlen);
-				format++;
-				continue;
-			}
-			else {
-				// yes, evaluate it
-				format++;
-			}
 
-			// evaluate flags
-			flags = 0U;
-			do {
-				switch (*format) {
-				case '0': flags |= FLAGS_ZEROPAD; format++; n = 1U; break;
-				case '-': flags |= FLAGS_LEFT;    format++; n = 1U; break;
-				case '+': flags |= FLAGS_PLUS;    format++; n = 1U; break;
-				case ' ': flags |= FLAGS_SPACE;   format++; n = 1U; break;
-				case '#': flags |= FLAGS_HASH;    format++; n = 1U; break;
-				default:                                   n = 0U; break;
-				}
-			} while (n);
+	// log ring counters, taken while it runs
+	inline log_stats_type log_stats(const log_ring_type* ring)
+	{
+		return {
+			ring->head.load(std::memory_order_relaxed),
+			ring->bytes.load(std::memory_order_relaxed),
+			ring->writes.load(std::memory_order_relaxed),
+			ring->drops.load(std::memory_order_relaxed),
+			ring->overwrites.load(std::memory_order_relaxed),
+			ring->truncated.load(std::memory_order_relaxed),
+			ring->invalid.load(std::memory_order_relaxed),
+			ring->high_water.load(std::memory_order_relaxed)
+		};
+	}
 
-			// evaluate width field
-			width = 0U;
-			if (_is_digit(*format)) {
-				width = _atoi(&format);
+
+	// binary log decoder state, the formats of its dictionary
+	typedef struct {
+		bool header;                          // seen and checked
+		std::vector<std::string> formats;     // by id
+		std::vector<bool> defined;            // by id, given by an 'F' entry, the others are gaps
+	} log_decoder_type;
+
+
+	// decode a binary log into text, in pieces, each call taking up where the last one stopped
+	// out gets the text in blocks, like the output function of fctprintf_block()
+	// \return The number of bytes decoded, the rest of an entry cut in two is for the next call;
+	//         -1 when the data is not a binary log of this version and byte order, or a record
+	//         does not suit its format, the text of the entries before it is written out
+	inline ptrdiff_t log_decode(log_decoder_type* decoder, const char* data, size_t size, void(*out)(const char* data, size_t len, void* arg), void* arg)
+	{
+		using namespace inner;
+		const char* p = data;
+		const char* const end = data + size;
+		if (!decoder->header) {
+			log_file_header_type header;
+			if (size < sizeof(header)) {
+				return 0;
 			}
-			else if (*format == '*') {
-				const int w = va_arg(va, int);
-				if (w < 0) {
-					flags |= FLAGS_LEFT;    // reverse padding
-					width = (unsigned int)-w;
-				}
-				else {
-					width = (unsigned int)w;
-				}
-				format++;
+			std::memcpy(&header, p, sizeof(header));
+			if (std::memcmp(header.magic, "printf++", sizeof(header.magic)) || (header.order != 0x01020304U) || (header.version != 1U)) {
+				return -1;
 			}
+			decoder->header = true;
+			p += sizeof(header);
+		}
 
-			// evaluate precision field
-			precision = 0U;
-			if (*format == '.') {
-				flags |= FLAGS_PRECISION;
-				format++;
-				if (_is_digit(*format)) {
-					precision = _atoi(&format);
-				}
-				else if (*format == '*') {
-					precision = (unsigned int)va_arg(va, int);
-					format++;
+		out_fct_stage_type stage;
+		stage.fct = out;
+		stage.arg = arg;
+		stage.len = 0U;
+		uint16_t id, length;
+		while (end - p >= 3) {
+			const char* entry = p + 1;
+			std::memcpy(&id, entry, sizeof(id));    // or the length of a text
+			if (*p == 'T') {
+				if ((size_t)(end - p) < 3U + id) {
+					break;
 				}
+				_out_fct_stage_block(p + 3, id, (char*)&stage, 0U, 0U);
+				p += 3U + id;
 			}
-
-			// evaluate length field
-			switch (*format) {
-			case 'l':
-				flags |= FLAGS_LONG;
-				format++;
-				if (*format == 'l') {
-					flags |= FLAGS_LONG_LONG;
-					format++;
-				}
-				break;
-			case 'h':
-				flags |= FLAGS_SHORT;
-				format++;
-				if (*format == 'h') {
-					flags |= FLAGS_CHAR;
-					format++;
+			else if (*p == 'F') {
+				if (end - p < 5) {
+					break;
 				}
-				break;
-#if defined(PRINTF_SUPPORT_PTRDIFF_T)
-			case 't':
-				flags |= (sizeof(ptrdiff_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
-				format++;
-				break;
-#endif
-			case 'j':
-				flags |= (sizeof(intmax_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
-				format++;
-				break;
-			case 'z':
-				flags |= (sizeof(size_t) == sizeof(long) ? FLAGS_LONG : FLAGS_LONG_LONG);
-				format++;
-				break;
-			default:
-				break;
-			}
-
-			// evaluate specifier
-			switch (*format) {
-			case 'd':
-			case 'i':
-			case 'u':
-			case 'x':
-			case 'X':
-			case 'o':
-			case 'b': {
-				// set the base
-				unsigned int base;
-				if (*format == 'x' || *format == 'X') {
-					base = 16U;
-				}
-				else if (*format == 'o') {
-					base = 8U;
-				}
-				else if (*format == 'b') {
-					base = 2U;
-					flags &= ~FLAGS_HASH;   // no hash for bin format
+				std::memcpy(&length, entry + 2, sizeof(length));
+				if ((size_t)(end - p) < 5U + length) {
+					break;
 				}
-				else {
-					base = 10U;
-					flags &= ~FLAGS_HASH;   // no hash for dec format
+				if (decoder->formats.size() <= id) {
+					decoder->formats.resize((size_t)id + 1U);
+					decoder->defined.resize((size_t)id + 1U);
 				}
-				// uppercase
-				if (*format == 'X') {
-					flags |= FLAGS_UPPERCASE;
+				decoder->formats[id].assign(p + 5, length);
+				decoder->defined[id] = true;
+				p += 5U + length;
+			}
+			else if (*p == 'R') {
+				if (end - p < 4) {
+					break;
 				}
-
-				// no plus or space flag for u, x, X, o, b
-				if ((*format != 'i') && (*format != 'd')) {
-					flags &= ~(FLAGS_PLUS | FLAGS_SPACE);
+				const size_t count = (unsigned char)p[3];
+				if ((id >= decoder->defined.size()) || !decoder->defined[id] || (count > PRINTF_LOG_DEFER_ARGS)) {
+					_fct_stage_flush(&stage);
+					return -1;
 				}
-
-				// convert the integer
-				if ((*format == 'i') || (*format == 'd')) {
-					// signed
-					if (flags & FLAGS_LONG_LONG) {
-#if defined(PRINTF_SUPPORT_LONG_LONG)
-						const long long value = va_arg(va, long long);
-						idx = _ntoa_long_long(out, buffer, idx, maxlen, (unsigned long long)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
-#endif
+				arg_type args[PRINTF_LOG_DEFER_ARGS];
+				const char* q = p + 4;
+				size_t i = 0U;
+				for (; i < count; ++i) {
+					if (end - q < 3) {
+						break;
 					}
-					else if (flags & FLAGS_LONG) {
-						const long value = va_arg(va, long);
-						idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned long)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
-					}
-					else {
-						const int value = (flags & FLAGS_CHAR) ? (char)va_arg(va, int) : (flags & FLAGS_SHORT) ? (short int)va_arg(va, int) : va_arg(va, int);
-						idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned int)(value > 0 ? value : 0 - value), value < 0, base, precision, width, flags);
+					args[i] = arg_type{};
+					args[i].type = (unsigned char)*q++;
+					if (args[i].type == ARG_STRING) {
+						std::memcpy(&length, q, sizeof(length));
+						if (length == PRINTF_LOG_NULL_STRING) {
+							args[i].s = nullptr;
+							args[i].length = (size_t)-1;
+							q += sizeof(length);
+							continue;
+						}
+						if ((size_t)(end - q) < sizeof(length) + length) {
+							break;
+						}
+						args[i].s = q + sizeof(length);
+						args[i].length = length;
+						q += sizeof(length) + length;
+						continue;
 					}
-				}
-				else {
-					// unsigned
-					if (flags & FLAGS_LONG_LONG) {
-#if defined(PRINTF_SUPPORT_LONG_LONG)
-						idx = _ntoa_long_long(out, buffer, idx, maxlen, va_arg(va, unsigned long long), false, base, precision, width, flags);
-#endif
+					const unsigned int bytes = (unsigned char)*q++;
+					if ((args[i].type < ARG_SIGNED) || (args[i].type > ARG_POINTER) || !bytes || (bytes > sizeof(args[i].u))) {
+						_fct_stage_flush(&stage);
+						return -1;
 					}
-					else if (flags & FLAGS_LONG) {
-						idx = _ntoa_long(out, buffer, idx, maxlen, va_arg(va, unsigned long), false, base, precision, width, flags);
+					if ((size_t)(end - q) < bytes) {
+						break;
 					}
-					else {
-						const unsigned int value = (flags & FLAGS_CHAR) ? (unsigned char)va_arg(va, unsigned int) : (flags & FLAGS_SHORT) ? (unsigned short int)va_arg(va, unsigned int) : va_arg(va, unsigned int);
-						idx = _ntoa_long(out, buffer, idx, maxlen, value, false, base, precision, width, flags);
+					unsigned long long value = 0U;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+					std::memcpy((char*)&value + sizeof(value) - bytes, q, bytes);
+#else
+					std::memcpy(&value, q, bytes);
+#endif
+					q += bytes;
+					if ((args[i].type == ARG_SIGNED) && (bytes < sizeof(value))) {
+						// sign extended, the integer conversions look at the sign of the whole
+						const unsigned int shift = (unsigned int)(sizeof(value) - bytes) * 8U;
+						value = (unsigned long long)((long long)(value << shift) >> shift);
 					}
+					args[i].size = args[i].type <= ARG_UNSIGNED ? bytes : 0U;
+					args[i].u = value;
 				}
-				format++;
-				break;
-			}
-#if defined(PRINTF_SUPPORT_FLOAT)
-			case 'f':
-			case 'F':
-				idx = _ftoa(out, buffer, idx, maxlen, va_arg(va, double), precision, width, flags);
-				format++;
-				break;
-#endif  // PRINTF_SUPPORT_FLOAT
-			case 'c': {
-				unsigned int l = 1U;
-				// pre padding
-				if (!(flags & FLAGS_LEFT)) {
-					while (l++ < width) {
-						out(' ', buffer, idx++, maxlen);
-					}
+				if (i < count) {
+					break;
 				}
-				// char output
-				out((char)va_arg(va, int), buffer, idx++, maxlen);
-				// post padding
-				if (flags & FLAGS_LEFT) {
-					while (l++ < width) {
-						out(' ', buffer, idx++, maxlen);
-					}
+				// the arguments are checked against the format first, a record which does not suit it
+				// is not rendered in part
+				const char* format = decoder->formats[id].c_str();
+				if (_vformat(out_null_sink_type{}, nullptr, 0U, format, args, count) < 0) {
+					_fct_stage_flush(&stage);
+					return -1;
 				}
-				format++;
-				break;
+				_vformat(_out_fct_stage_block, (char*)&stage, (size_t)-1, format, args, count);
+				p = q;
 			}
-
-			case 's': {
-				char* p = va_arg(va, char*);
-				unsigned int l = _strlen(p);
-				// pre padding
-				if (flags & FLAGS_PRECISION) {
-					l = (l < precision ? l : precision);
-				}
-				if (!(flags & FLAGS_LEFT)) {
-					while (l++ < width) {
-						out(' ', buffer, idx++, maxlen);
-					}
-				}
-				// string output
-				while ((*p != 0) && (!(flags & FLAGS_PRECISION) || precision--)) {
-					out(*(p++), buffer, idx++, maxlen);
-				}
-				// post padding
-				if (flags & FLAGS_LEFT) {
-					while (l++ < width) {
-						out(' ', buffer, idx++, maxlen);
-					}
-				}
-				format++;
-				break;
+			else {
+				_fct_stage_flush(&stage);
+				return -1;
 			}
+		}
+		_fct_stage_flush(&stage);
+		return p - data;
+	}
+#endif  // PRINTF_SUPPORT_LOG_RING
 
-			case 'p': {
-				width = sizeof(void*) * 2U;
-				flags |= FLAGS_ZEROPAD | FLAGS_UPPERCASE;
-#if defined(PRINTF_SUPPORT_LONG_LONG)
-				const bool is_ll = sizeof(uintptr_t) == sizeof(long long);
-				if (is_ll) {
-					idx = _ntoa_long_long(out, buffer, idx, maxlen, (uintptr_t)va_arg(va, void*), false, 16U, precision, width, flags);
-				}
-				else {
-#endif
-					idx = _ntoa_long(out, buffer, idx, maxlen, (unsigned long)((uintptr_t)va_arg(va, void*)), false, 16U, precision, width, flags);
-#if defined(PRINTF_SUPPORT_LONG_LONG)
-				}
-#endif
-				format++;
-				break;
-			}
 
-			case '%':
-				out('%', buffer, idx++, maxlen);
-				format++;
-				break;
+	typedef struct {
+		size_t hits;
+		size_t misses;
+		size_t entries;
+	} format_cache_stats_type;
 
-			default:
-				out(*format, buffer, idx++, maxlen);
-				format++;
-				break;
-			}
-		}
 
-		// termination
-		out((char)0, buffer, idx < maxlen ? idx : maxlen - 1U, maxlen);
+	// format cache statistics, the cache is used by snprintf_cached() and vsnprintf_cached()
+	PRINTF_EXTERN_C inline format_cache_stats_type format_cache_stats()
+	{
+		using namespace inner;
+		return {
+			format_cache.hits.load(std::memory_order_relaxed),
+			format_cache.misses.load(std::memory_order_relaxed),
+			format_cache.entries.load(std::memory_order_relaxed)
+		};
+	}
 
-		// return written chars without terminating \0
-		return (int)idx;
+
+	// conversion counters of all threads, see format_stats()
+	typedef struct {
+		size_t calls;                                       // formatting calls
+		size_t bytes;                                       // characters of their complete output
+		size_t truncated;                                   // calls whose output did not fit the buffer
+		size_t specifiers[inner::PRINTF_STATS_SPECIFIERS];  // conversions by specifier character
+		size_t flags[inner::PRINTF_STATS_FLAGS];            // conversions by the flags 0 - + space # (bits 0 to 4),
+		                                                    // a width (bit 5) and a precision (bit 6)
+	} format_stats_type;
+
+
+	// conversion counters added up over the threads running and gone, all zero unless
+	// PRINTF_SUPPORT_INSTRUMENTATION is defined; the threads running go on counting meanwhile
+	inline format_stats_type format_stats()
+	{
+		format_stats_type stats{};
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+		using namespace inner;
+		format_counters_type sum{};
+		{
+			std::lock_guard<std::mutex> lock(format_counters_mutex);
+			_counters_add(&sum, &format_counters_retired);
+			for (const format_counters_node_type* node = format_counters_threads; node; node = node->next) {
+				_counters_add(&sum, &node->counters);
+			}
+		}
+		stats.calls = sum.calls.load(std::memory_order_relaxed);
+		stats.bytes = sum.bytes.load(std::memory_order_relaxed);
+		stats.truncated = sum.truncated.load(std::memory_order_relaxed);
+		for (unsigned int i = 0U; i < PRINTF_STATS_SPECIFIERS; ++i) {
+			stats.specifiers[i] = sum.specifiers[i].load(std::memory_order_relaxed);
+		}
+		for (unsigned int i = 0U; i < PRINTF_STATS_FLAGS; ++i) {
+			stats.flags[i] = sum.flags[i].load(std::memory_order_relaxed);
+		}
+#endif
+		return stats;
 	}
 
 
-///////////////////////////////////////////////////////////////////////////////
-} // namespace inner 
-///////////////////////////////////////////////////////////////////////////////
+	// type safe format, the conversions use the real types of the arguments, not the varargs promotions
+	// sink is a char array, which is 0 terminated, or a callable taking (const char* data, size_t len)
+	// format is a format string, or a PRINTF_FMT format whose conversions are checked against
+	// the arguments at compile time; the length modifiers are not needed, and are ignored
+	// \return The number of characters for the complete output (like snprintf), or -1 when
+	//         an argument is missing or its type does not suit its specifier
+	template <typename Sink, typename F, typename... Args>
+	inline int format(Sink&& sink, const F& fmt, const Args&... args)
+	{
+		using namespace inner;
+		using sink_type = std::remove_reference_t<Sink>;
+		if constexpr (is_format_string_v<F>) {
+			static_assert(_args_match<F, Args...>(), "format(): the arguments do not suit the conversions of the format");
+		}
+		else {
+			static_assert(std::is_convertible_v<const F&, const char*>, "format(): the format is a string or a PRINTF_FMT format");
+		}
+		const arg_type argv[sizeof...(Args) + 1U] = { _make_arg(args)... };
+
+		if constexpr (std::is_array_v<sink_type>) {
+			static_assert(std::is_same_v<std::remove_cv_t<std::remove_extent_t<sink_type>>, char> && !std::is_const_v<std::remove_extent_t<sink_type>>, "format(): the sink array must be a char array");
+			constexpr size_t size = std::extent_v<sink_type>;
+			const int ret = _format_args(out_buffer_sink_type{}, sink, size, fmt, argv, sizeof...(Args));
+			if (size) {
+				sink[((ret >= 0) && ((size_t)ret < size)) ? (size_t)ret : size - 1U] = '\0';
+			}
+			return ret;
+		}
+		else {
+			static_assert(std::is_invocable_v<sink_type&, const char*, size_t>, "format(): the sink is a char array, or a callable taking (const char* data, size_t len)");
+			return _format_args(out_callable_sink_type<sink_type>{}, (char*)(void*)&sink, (size_t)-1, fmt, argv, sizeof...(Args));
+		}
+	}
 
 
-	PRINTF_EXTERN_C inline int printf(const char* format, ...)
+	// versions taking a PRINTF_FMT format, parsed at compile time
+	// only the conversions of the arguments are done at run time, e.g.
+	//   snprintf(buffer, sizeof(buffer), PRINTF_FMT("%s: %d items"), name, count);
+	template <typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int printf(F, Args... args)
 	{
 		using namespace inner;
-		va_list va;
-		va_start(va, format);
+#if defined(PRINTF_USER_DEFINED_PUTCHAR)
 		char buffer[1];
-		const int ret = _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
-		va_end(va);
+		return _snprintf_ops(_out_char_block, buffer, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
+#else
+		out_stdout_type* stage = _stdout_buffer();
+		const int ret = _snprintf_ops(_out_stdout_block, (char*)stage, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
+		_stdout_flush(stage);
 		return ret;
+#endif
 	}
 
 
-	PRINTF_EXTERN_C inline int sprintf(char* buffer, const char* format, ...)
+	template <typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int sprintf(char* buffer, F, Args... args)
 	{
 		using namespace inner;
-		va_list va;
-		va_start(va, format);
-		const int ret = _vsnprintf(_out_buffer, buffer, (size_t)-1, format, va);
-		va_end(va);
-		return ret;
+		return _snprintf_ops(_out_buffer_block, buffer, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
 	}
 
 
-	PRINTF_EXTERN_C  inline int snprintf(char* buffer, size_t count, const char* format, ...)
+	template <typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int snprintf(char* buffer, size_t count, F, Args... args)
 	{
 		using namespace inner;
-		va_list va;
-		va_start(va, format);
-		const int ret = _vsnprintf(_out_buffer, buffer, count, format, va);
-		va_end(va);
-		return ret;
+		return _snprintf_ops(_out_buffer_block, buffer, count, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
 	}
 
 
-	PRINTF_EXTERN_C  inline int vsnprintf(char* buffer, size_t count, const char* format, va_list va)
+	template <typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int fctprintf(void(*out)(char character, void* arg), void* arg, F, Args... args)
 	{
-		return inner::_vsnprintf(inner::_out_buffer, buffer, count, format, va);
+		using namespace inner;
+		const out_fct_wrap_type out_fct_wrap = { out, arg };
+		return _snprintf_ops(_out_fct_block, (char*)&out_fct_wrap, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
 	}
 
 
-	PRINTF_EXTERN_C inline int fctprintf(void(*out)(char character, void* arg), void* arg, const char* format, ...)
+	template <typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int fctprintf_block(void(*out)(const char* data, size_t len, void* arg), void* arg, F, Args... args)
 	{
-		va_list va;
-		va_start(va, format);
-		const inner::out_fct_wrap_type out_fct_wrap = { out, arg };
-		const int ret = inner::_vsnprintf( inner::_out_fct, (char*)&out_fct_wrap, (size_t)-1, format, va);
-		va_end(va);
+		using namespace inner;
+		out_fct_stage_type stage;
+		stage.fct = out;
+		stage.arg = arg;
+		stage.len = 0U;
+		const int ret = _snprintf_ops(_out_fct_stage_block, (char*)&stage, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
+		stage.len--;
+		_fct_stage_flush(&stage);
 		return ret;
 	}
 
+
+	template <typename C, typename F, typename... Args, std::enable_if_t<inner::is_format_string_v<F>, int> = 0>
+	inline int format_to(C& out, F, Args... args)
+	{
+		using namespace inner;
+		static_assert(std::is_same_v<C, std::string> || std::is_same_v<C, std::vector<char>>, "format_to(): the output is a std::string or a std::vector<char>");
+		out_grow_type<C> grow;
+		_grow_start(&grow, &out);
+		const int ret = _snprintf_ops(_out_grow_block<C>, (char*)&grow, (size_t)-1, compiled_format<F>::format, compiled_format<F>::ops.op, args...);
+		_grow_finish(&grow, ret);
+		return grow.failed ? -1 : ret;
+	}
+
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+	namespace literals {
+		// C++20 alternative to PRINTF_FMT, e.g. snprintf(buffer, size, "%d items"_fmt, count);
+		template <inner::fixed_string S>
+		constexpr auto operator""_fmt() {
+			return inner::fixed_format<S>{};
+		}
+	}
+#endif
+
 } // namespace mpaland_dbjdbj 
 
+// format string parsed at compile time, for the printf, sprintf, snprintf and fctprintf versions taking it
+#define PRINTF_FMT(s) ([] { \
+		struct printf_fmt : mpaland_dbjdbj::inner::format_string_tag { \
+			static constexpr const char* c_str() { return s; } \
+		}; \
+		return printf_fmt{}; \
+	}())
+
 ///////////////////////////////////////////////////////////////////////////////
 // \author (c) C VERSION -- Marco Paland (info@paland.com)
 //             2014-2018, PALANDesign Hannover, Germany
@@ -0,0 +1,134 @@
+// license at eof
+// printf() staging of the standard output, in a program of its own: the canonical _putchar is
+// needed, where the test suite defines its own; POSIX only, the standard output is redirected
+// build it as it is, and once more with -DPRINTF_STDOUT_LINE_FLUSH, e.g.
+//   g++ -std=c++17 test/cpp_test_stdout.cpp -o cpp_test_stdout
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+// every hand over is one write(2), to be told apart
+#define PRINTF_STDOUT_USE_WRITE
+#include "../printf++.h"
+
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// the standard output redirected to a packet socket, each write(2) is read back as one packet
+class stdout_capture {
+	int fds_[2];
+	int saved_;
+public:
+	stdout_capture()
+	{
+		REQUIRE(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds_) == 0);
+		saved_ = dup(1);
+		REQUIRE(dup2(fds_[0], 1) == 1);
+	}
+	~stdout_capture()
+	{
+		dup2(saved_, 1);
+		close(saved_);
+		close(fds_[0]);
+		close(fds_[1]);
+	}
+	// the writes so far
+	std::vector<std::string> writes()
+	{
+		std::vector<std::string> packets;
+		char data[8192];
+		ssize_t len;
+		while ((len = recv(fds_[1], data, sizeof(data), MSG_DONTWAIT)) > 0) {
+			packets.emplace_back(data, (size_t)len);
+		}
+		return packets;
+	}
+};
+
+
+std::string joined(const std::vector<std::string>& packets)
+{
+	std::string all;
+	for (const std::string& packet : packets) {
+		all += packet;
+	}
+	return all;
+}
+
+
+TEST_CASE("stdout per call", "[]") {
+	stdout_capture capture;
+
+	// handed over once at the end of each call, nothing is left staged
+	REQUIRE(mpaland_dbjdbj::printf("%s=%d;", "a", 1) == 4);
+	REQUIRE(capture.writes() == std::vector<std::string>{ "a=1;" });
+	REQUIRE(mpaland_dbjdbj::printf("b") == 1);
+	REQUIRE(mpaland_dbjdbj::printf(PRINTF_FMT("%x"), 255U) == 2);
+	REQUIRE(capture.writes() == std::vector<std::string>{ "b", "ff" });
+
+	// no output, no write, and 0 characters are not written out
+	REQUIRE(mpaland_dbjdbj::printf("") == 0);
+	REQUIRE(capture.writes().empty());
+	REQUIRE(mpaland_dbjdbj::printf("x%cy", 0) == 3);
+	REQUIRE(joined(capture.writes()) == "xy");
+}
+
+
+TEST_CASE("stdout larger than the stage", "[]") {
+	using mpaland_dbjdbj::inner::PRINTF_STDOUT_BUFFER_SIZE;
+	stdout_capture capture;
+
+	// the staged head goes out first, the long field directly after it
+	const std::string tail(3000U, 'z');
+	REQUIRE(mpaland_dbjdbj::printf("head|%s|%5d", tail.c_str(), 42) == 3011);
+	std::vector<std::string> packets = capture.writes();
+	REQUIRE(joined(packets) == "head|" + tail + "|   42");
+	REQUIRE(packets.size() == 3U);
+
+	// many short blocks, in full stages
+	std::string expected;
+	for (int i = 0; i < 200; i++) {
+		expected += "0123456789";
+	}
+	REQUIRE(mpaland_dbjdbj::printf("%s%s%s%s%s%s%s%s%s%s", expected.c_str(), "", "", "", "", "", "", "", "", "") == 2000);
+	packets = capture.writes();
+	REQUIRE(joined(packets) == expected);
+	for (const std::string& packet : packets) {
+		REQUIRE((packet.size() <= PRINTF_STDOUT_BUFFER_SIZE || packet.size() == expected.size()));
+	}
+
+	REQUIRE(mpaland_dbjdbj::printf("%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%1000d|", 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10) == 1021);
+	packets = capture.writes();
+	REQUIRE(joined(packets).size() == 1021U);
+	REQUIRE(joined(packets).compare(0U, 20U, "0|1|2|3|4|5|6|7|8|9|") == 0);
+	for (const std::string& packet : packets) {
+		REQUIRE(packet.size() <= PRINTF_STDOUT_BUFFER_SIZE);
+	}
+}
+
+
+TEST_CASE("stdout lines", "[]") {
+	stdout_capture capture;
+
+	REQUIRE(mpaland_dbjdbj::printf("one\ntwo %d\nthree", 2) == 15);
+#if defined(PRINTF_STDOUT_LINE_FLUSH)
+	// handed over at each new line
+	REQUIRE(capture.writes() == std::vector<std::string>{ "one\n", "two 2\n", "three" });
+#else
+	REQUIRE(capture.writes() == std::vector<std::string>{ "one\ntwo 2\nthree" });
+#endif
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// \author (c) C VERSION -- Marco Paland (info@paland.com)
+//             2014-2018, PALANDesign Hannover, Germany
+//         (c) CPP HEADER ONLY VERSION -- Dusan B. Jovanovic ( dbj@dbj.org )
+//             2018, dbj.systems, London, UK
+//
+// \license The MIT License (MIT)
+///////////////////////////////////////////////////////////////////////////////
@@ -4,10 +4,13 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+// build it as it is, and once more with the options, e.g.
+//   -DPRINTF_SUPPORT_FORMAT_ARENA -DPRINTF_SUPPORT_LOG_RING -DPRINTF_SUPPORT_INSTRUMENTATION
 #define PRINTF_USER_DEFINED_PUTCHAR
 #include "../printf++.h"
 
 #include <string.h>
+#include <thread>
 
 namespace test {
 	constexpr inline auto printf_buffer_size = 100U;
@@ -61,6 +64,15 @@ TEST_CASE("snprintf", "[]") {
 }
 
 
+static int call_vsnprintf(mpaland_dbjdbj::inner::out_fct_type out, char* buffer, size_t maxlen, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	const int ret = mpaland_dbjdbj::inner::_vsnprintf(out, buffer, maxlen, format, args);
+	va_end(args);
+	return ret;
+}
+
 static void vsnprintf_builder_1(char* buffer, ...)
 {
 	va_list args;
@@ -924,15 +936,21 @@ TEST_CASE("float", "[]") {
 	mpaland_dbjdbj::sprintf(buffer, "%.10f", 42.895223);
 	REQUIRE(!strcmp(buffer, "42.8952230000"));
 
-	// this testcase checks, that the precision is truncated to 9 digits.
-	// a perfect working float should return the whole number
+	// precisions beyond 9 digits are exact
 	mpaland_dbjdbj::sprintf(buffer, "%.12f", 42.89522312345678);
-	REQUIRE(!strcmp(buffer, "42.895223123000"));
+	REQUIRE(!strcmp(buffer, "42.895223123457"));
 
-	// this testcase checks, that the precision is truncated AND rounded to 9 digits.
-	// a perfect working float should return the whole number
 	mpaland_dbjdbj::sprintf(buffer, "%.12f", 42.89522387654321);
-	REQUIRE(!strcmp(buffer, "42.895223877000"));
+	REQUIRE(!strcmp(buffer, "42.895223876543"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.19f|%.17f|%.25f", 0.1, 1.0 / 3.0, 0.1);
+	REQUIRE(!strcmp(buffer, "0.1000000000000000056|0.33333333333333331|0.1000000000000000055511151"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.2f %.2f %.0f %.0f %.3f", 0.125, 0.375, 0.5, 1.5, 0.0005);
+	REQUIRE(!strcmp(buffer, "0.12 0.38 0 2 0.001"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.1f %f %08.3f", -0.0, 1e-7, -1.0005);
+	REQUIRE(!strcmp(buffer, "-0.0 0.000000 -001.000"));
 
 	mpaland_dbjdbj::sprintf(buffer, "%6.2f", 42.8952);
 	REQUIRE(!strcmp(buffer, " 42.90"));
@@ -967,9 +985,99 @@ TEST_CASE("float", "[]") {
 	mpaland_dbjdbj::sprintf(buffer, "%.1f", 3.49);
 	REQUIRE(!strcmp(buffer, "3.5"));
 
-	// out of range in the moment, need to be fixed by someone
+	// large values take the exact conversion
 	mpaland_dbjdbj::sprintf(buffer, "%.1f", 1E20);
-	REQUIRE(!strcmp(buffer, ""));
+	REQUIRE(!strcmp(buffer, "100000000000000000000.0"));
+}
+
+
+TEST_CASE("large float", "[]") {
+	char buffer[400];
+
+	mpaland_dbjdbj::sprintf(buffer, "%.0f", 1e308);
+	REQUIRE(!strcmp(buffer, "10000000000000000109790636294404554174049230967731184633681068290315758540491149153716332897849468889906124966972117251561159028374314008832830700919814604"
+		"6031271664502933027185697489699588559043338384466165001178426897626212945177628091195786707458122783970171784415105291802893207873272974885715430223118336"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.2f|%.3f|%f", -18446744073709551616.0, 4294967296.5, 1e22);
+	REQUIRE(!strcmp(buffer, "-18446744073709551616.00|4294967296.500|10000000000000000000000.000000"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%+30.1f|%-16.0f|%016.1f", 3e20, 4e9, -5e9);
+	REQUIRE(!strcmp(buffer, "      +300000000000000000000.0|4000000000      |-0005000000000.0"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%f %F %5.1f", 1e300 * 1e300, -(1e300 * 1e300), 0.0 * (1e300 * 1e300));
+	REQUIRE(!strncmp(buffer, "inf -INF ", 9));
+
+	// all 751 significant digits of the smallest subnormal, none of them cut
+	char digits[1200];
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.800g", 5e-324) == 757);
+	REQUIRE(!strcmp(digits + 740, "533447265625e-324"));
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.1080f", 5e-324) == 1082);
+	REQUIRE(!strcmp(digits + 1064, "533447265625000000"));
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.400e", 5e-324) == 407);
+	REQUIRE(!strcmp(digits + 387, "656332452475715e-324"));
+
+	// zero with more fraction digits than the 64 bit path has
+	const std::string zeros(1000U, '0');
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.1000f", 0.0) == 1002);
+	REQUIRE(digits == "0." + zeros);
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.1000f", -0.0) == 1003);
+	REQUIRE(digits == "-0." + zeros);
+	REQUIRE(mpaland_dbjdbj::sprintf(digits, "%.20f|%.19f", 0.0, -0.0) == 45);
+	REQUIRE(!strcmp(digits, "0.00000000000000000000|-0.0000000000000000000"));
+}
+
+
+TEST_CASE("exponential", "[]") {
+	char buffer[100];
+
+	mpaland_dbjdbj::sprintf(buffer, "%e", 1.5);
+	REQUIRE(!strcmp(buffer, "1.500000e+00"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.3E", -123456.789);
+	REQUIRE(!strcmp(buffer, "-1.235E+05"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%+012.2e", 3.14159);
+	REQUIRE(!strcmp(buffer, "+0003.14e+00"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%-12e|", 0.0);
+	REQUIRE(!strcmp(buffer, "0.000000e+00|"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.0e %e", 5e-324, 1e308);
+	REQUIRE(!strcmp(buffer, "5e-324 1.000000e+308"));
+
+	// the exact value, rounded half to even
+	mpaland_dbjdbj::sprintf(buffer, "%.20e", 0.1);
+	REQUIRE(!strcmp(buffer, "1.00000000000000005551e-01"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%.1e %.1e %.0e", 2.25, 2.35, 2.5);
+	REQUIRE(!strcmp(buffer, "2.2e+00 2.4e+00 2e+00"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%g %g %g %g", 0.0001, 0.00001, 123456.0, 1234567.0);
+	REQUIRE(!strcmp(buffer, "0.0001 1e-05 123456 1.23457e+06"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%#g %G %.17g", 100.0, 1e-10, 0.1);
+	REQUIRE(!strcmp(buffer, "100.000 1E-10 0.10000000000000001"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%g %5G %-6g|", -0.0, 1e300 * 1e300, -(1e300 * 1e300));
+	REQUIRE(!strcmp(buffer, "-0   INF -inf  |"));
+}
+
+
+TEST_CASE("hex float", "[]") {
+	char buffer[100];
+
+	mpaland_dbjdbj::sprintf(buffer, "%a %a %A %a", 1.0, 0.1, 255.5, 0.0);
+	REQUIRE(!strcmp(buffer, "0x1p+0 0x1.999999999999ap-4 0X1.FFP+7 0x0p+0"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%a %.2a", 5e-324, 2.2250738585072009e-308);
+	REQUIRE(!strcmp(buffer, "0x0.0000000000001p-1022 0x1.00p-1022"));
+
+	// rounded half to even
+	mpaland_dbjdbj::sprintf(buffer, "%.0a %.0a %.0a %.1a", 1.5, 2.5, 1.9, 1.96875);
+	REQUIRE(!strcmp(buffer, "0x2p+0 0x1p+1 0x2p+0 0x2.0p+0"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%#.0a|%020a|%-12a|%+a|%.15a", 1.0, -1.5, 1.0, 1.0, 0.1);
+	REQUIRE(!strcmp(buffer, "0x1.p+0|-0x000000000001.8p+0|0x1p+0      |+0x1p+0|0x1.999999999999a00p-4"));
 }
 
 
@@ -1197,6 +1305,14 @@ TEST_CASE("misc", "[]") {
 	mpaland_dbjdbj::sprintf(buffer, "%.*f", 2, 0.33333333);
 	REQUIRE(!strcmp(buffer, "0.33"));
 
+	// a negative precision argument is taken as omitted
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), "%.*f|", -1, 3.25) == 9);
+	REQUIRE(!strcmp(buffer, "3.250000|"));
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), "%.*e|", -1, 3.25) == 13);
+	REQUIRE(!strcmp(buffer, "3.250000e+00|"));
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), "%.*g|", -1, 3.25) == 5);
+	REQUIRE(!strcmp(buffer, "3.25|"));
+
 	mpaland_dbjdbj::sprintf(buffer, "%.3s", "foobar");
 	REQUIRE(!strcmp(buffer, "foo"));
 
@@ -1208,6 +1324,768 @@ TEST_CASE("misc", "[]") {
 }
 
 
+TEST_CASE("block output", "[]") {
+	using namespace mpaland_dbjdbj::inner;
+	char buffer[100];
+
+	// character sinks are adapted to the block output
+	test::reset_buffering();
+	REQUIRE(call_vsnprintf(_out_buffer, buffer, 100U, "%-6s|%5d|%c", "abc", -42, 'z') == 14);
+	REQUIRE(!strcmp(buffer, "abc   |  -42|z"));
+
+	REQUIRE(call_vsnprintf(_out_buffer, buffer, 5U, "literal text %d", 1) == 14);
+	REQUIRE(!strcmp(buffer, "lite"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%40s", "x");
+	REQUIRE(strlen(buffer) == 40U);
+	REQUIRE(buffer[38] == ' ');
+	REQUIRE(buffer[39] == 'x');
+
+	mpaland_dbjdbj::sprintf(buffer, "ab%-8.3fcd", 1.5);
+	REQUIRE(!strcmp(buffer, "ab1.500   cd"));
+}
+
+
+TEST_CASE("literal runs", "[]") {
+	char buffer[100];
+	char format[100];
+	const char* text = "0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+	// literal runs of every length, starting at every alignment
+	for (size_t offset = 0U; offset < 32U; offset++) {
+		for (size_t len = 0U; len < 40U; len++) {
+			memcpy(format + offset, text, len);
+			strcpy(format + offset + len, "%d!");
+			REQUIRE(mpaland_dbjdbj::sprintf(buffer, format + offset, 7) == (int)len + 2);
+			REQUIRE(!strncmp(buffer, text, len));
+			REQUIRE(!strcmp(buffer + len, "7!"));
+		}
+	}
+
+	mpaland_dbjdbj::sprintf(buffer, "%%%s%%%%", "x");
+	REQUIRE(!strcmp(buffer, "%x%%"));
+}
+
+
+TEST_CASE("compiled format", "[]") {
+	using namespace mpaland_dbjdbj::inner;
+	char buffer[100];
+
+	auto format = PRINTF_FMT("%s: %-5d|%*.*f|%%|%#x");
+	using compiled = compiled_format<decltype(format)>;
+	static_assert(compiled::ops.op[0].spec.specifier == 's', "compiled at compile time");
+	static_assert(compiled::ops.op[1].offset == 2U && compiled::ops.op[1].length == 2U, "literal run between the conversions");
+	static_assert(compiled::ops.op[1].spec.flags & FLAGS_LEFT, "flags parsed at compile time");
+	static_assert(compiled::ops.op[5].spec.specifier == '\0', "terminating operation");
+
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, 100U, format, "items", 42, 8, 2, 3.14159, 255) == 28);
+	REQUIRE(!strcmp(buffer, "items: 42   |    3.14|%|0xff"));
+
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, 6U, PRINTF_FMT("abc%ddef"), 12345) == 11);
+	REQUIRE(!strcmp(buffer, "abc12"));
+
+	mpaland_dbjdbj::sprintf(buffer, PRINTF_FMT("no conversion"));
+	REQUIRE(!strcmp(buffer, "no conversion"));
+
+	test::reset_buffering();
+	REQUIRE(mpaland_dbjdbj::printf(PRINTF_FMT("% d"), 4232) == 5);
+	REQUIRE(!strcmp(test::printf_buffer, " 4232"));
+
+	test::reset_buffering();
+	mpaland_dbjdbj::fctprintf(&_out_fct, nullptr, PRINTF_FMT("This is a test of %X"), 0x12EFU);
+	REQUIRE(!strcmp(test::printf_buffer, "This is a test of 12EF"));
+}
+
+
+TEST_CASE("format cache", "[]") {
+	static const char format[] = "cached %d|%-5s|%%";
+	static const char* const expected[] = { "cached 0|ab   |%", "cached 1|ab   |%", "cached 2|ab   |%" };
+	char buffer[100];
+
+	const mpaland_dbjdbj::format_cache_stats_type before = mpaland_dbjdbj::format_cache_stats();
+	for (int i = 0; i < 3; i++) {
+		REQUIRE(mpaland_dbjdbj::snprintf_cached(buffer, 100U, format, i, "ab") == 16);
+		REQUIRE(!strcmp(buffer, expected[i]));
+	}
+	const mpaland_dbjdbj::format_cache_stats_type after = mpaland_dbjdbj::format_cache_stats();
+	REQUIRE(after.misses - before.misses == 1U);
+	REQUIRE(after.hits - before.hits == 2U);
+	REQUIRE(after.entries - before.entries == 1U);
+
+	// too many conversions to be cached
+	static const char long_format[] = "%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d%d";
+	for (int i = 0; i < 2; i++) {
+		REQUIRE(mpaland_dbjdbj::snprintf_cached(buffer, 100U, long_format, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5, 6, 7) == 17);
+		REQUIRE(!strcmp(buffer, "12345678901234567"));
+	}
+	REQUIRE(mpaland_dbjdbj::format_cache_stats().hits == after.hits);
+
+	// the other calls do not use the cache, a format in a reused buffer may change
+	const size_t misses = mpaland_dbjdbj::format_cache_stats().misses;
+	char reused[32];
+	strcpy(reused, "%d and %d");
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, 100U, reused, 1, 2) == 7);
+	strcpy(reused, "%s");
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, 100U, reused, "new") == 3);
+	REQUIRE(!strcmp(buffer, "new"));
+	REQUIRE(mpaland_dbjdbj::format_cache_stats().misses == misses);
+}
+
+
+TEST_CASE("type safe format", "[]") {
+	char buffer[100];
+
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%d %u %s %c %.2f", -5, 7U, "str", 'x', 2.5f) == 15);
+	REQUIRE(!strcmp(buffer, "-5 7 str x 2.50"));
+
+	// the real types of the arguments, not the varargs promotions
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%x %x %hhd", (signed char)-1, (short)-1, 300) == 11);
+	REQUIRE(!strcmp(buffer, "ff ffff 300"));
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%d|%llu", -9223372036854775807LL - 1, 18446744073709551615ULL) >= 0);
+	REQUIRE(!strcmp(buffer, "-9223372036854775808|18446744073709551615"));
+
+	// strings need not be 0 terminated
+	const std::string_view view("abcdef", 3U);
+	mpaland_dbjdbj::format(buffer, "[%5s][%-*s]", view, 4, view);
+	REQUIRE(!strcmp(buffer, "[  abc][abc ]"));
+
+	// the type of each argument is checked against its specifier
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%s", 42) == -1);
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%d", 4.2) == -1);
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%d %d", 1) == -1);
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%*d", "x", 1) == -1);
+
+	// a char pointer for %p is written as a pointer, a null one for %s as (null)
+	char text[] = "text";
+	const char* null_string = nullptr;
+	char expected[100];
+	mpaland_dbjdbj::snprintf(expected, sizeof(expected), "%p|%p", (void*)text, (void*)text);
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%p|%p", text, (const char*)text) >= 0);
+	REQUIRE(!strcmp(buffer, expected));
+	REQUIRE(mpaland_dbjdbj::format(buffer, PRINTF_FMT("%p"), text) >= 0);
+	REQUIRE(!strcmp(buffer, expected + strlen(expected) / 2U + 1U));
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%p", std::string_view("view")) == -1);
+	REQUIRE(mpaland_dbjdbj::format(buffer, "[%s][%8s]", null_string, null_string) == 18);
+	REQUIRE(!strcmp(buffer, "[(null)][  (null)]"));
+
+	// a negative precision argument is taken as omitted
+	REQUIRE(mpaland_dbjdbj::format(buffer, "%.*f|%.*e|%.*g", -1, 3.25, -1, 3.25, -1, 3.25) == 26);
+	REQUIRE(!strcmp(buffer, "3.250000|3.250000e+00|3.25"));
+
+	// the char array is truncated and 0 terminated
+	char small[4];
+	REQUIRE(mpaland_dbjdbj::format(small, "%d", 123456) == 6);
+	REQUIRE(!strcmp(small, "123"));
+
+	// compiled format, checked at compile time
+	REQUIRE(mpaland_dbjdbj::format(buffer, PRINTF_FMT("%s=%#06x %p"), "id", 255U, (void*)0x10) >= 0);
+	if (sizeof(void*) == 8U) {
+		REQUIRE(!strcmp(buffer, "id=0x00ff 0000000000000010"));
+	}
+
+	// callable sink
+	std::size_t calls = 0U;
+	test::reset_buffering();
+	auto sink = [&calls](const char* data, std::size_t len) {
+		calls++;
+		memcpy(test::printf_buffer + test::printf_idx, data, len);
+		test::printf_idx += len;
+	};
+	REQUIRE(mpaland_dbjdbj::format(sink, "block %s %d!", "output", 42) == 16);
+	REQUIRE(!strcmp(test::printf_buffer, "block output 42!"));
+	REQUIRE(calls == 5U);
+}
+
+
+TEST_CASE("decimal digits", "[]") {
+	char buffer[100];
+
+	// around every power of 10
+	unsigned long long power = 1ULL;
+	for (unsigned int digits = 1U; digits <= 20U; digits++) {
+		mpaland_dbjdbj::sprintf(buffer, "%llu", power);
+		REQUIRE(strlen(buffer) == digits);
+		REQUIRE(buffer[0] == '1');
+		mpaland_dbjdbj::sprintf(buffer, "%llu", power - 1ULL);
+		REQUIRE(strlen(buffer) == (digits > 1U ? digits - 1U : 1U));
+		if (digits < 20U) {
+			power *= 10ULL;
+		}
+	}
+
+	mpaland_dbjdbj::sprintf(buffer, "%llu %lld %u", 18446744073709551615ULL, -9223372036854775807LL - 1, 0U);
+	REQUIRE(!strcmp(buffer, "18446744073709551615 -9223372036854775808 0"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%d|%05d|%-6d|%+.4d", 7, 42, 1234, 56);
+	REQUIRE(!strcmp(buffer, "7|00042|1234  |+0056"));
+}
+
+
+TEST_CASE("power of two bases", "[]") {
+	char buffer[100];
+
+	mpaland_dbjdbj::sprintf(buffer, "%llx %llX %llo", 18446744073709551615ULL, 18446744073709551615ULL, 18446744073709551615ULL);
+	REQUIRE(!strcmp(buffer, "ffffffffffffffff FFFFFFFFFFFFFFFF 1777777777777777777777"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%x %o %b %#x %#o", 0U, 0U, 0U, 1U, 8U);
+	REQUIRE(!strcmp(buffer, "0 0 0 0x1 010"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%b|%08b|%x|%X", 0x80000000U, 5U, 0x10U, 0xABCDEFU);
+	REQUIRE(!strcmp(buffer, "10000000000000000000000000000000|00000101|10|ABCDEF"));
+}
+
+
+TEST_CASE("hex block", "[]") {
+	char buffer[100];
+
+	mpaland_dbjdbj::sprintf(buffer, "%llx %llX %llx", 0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL, 0xA0000000000000FULL);
+	REQUIRE(!strcmp(buffer, "123456789abcdef FEDCBA9876543210 a0000000000000f"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%x|%#6x|%.4X|%-5x|", 0xfU, 0xabU, 0x1U, 0x10U);
+	REQUIRE(!strcmp(buffer, "f|  0xab|0001|10   |"));
+
+	mpaland_dbjdbj::sprintf(buffer, "%p", (void*)(uintptr_t)0x1234U);
+	if (sizeof(void*) == 8U) {
+		REQUIRE(!strcmp(buffer, "0000000000001234"));
+	}
+	else {
+		REQUIRE(!strcmp(buffer, "00001234"));
+	}
+}
+
+
+TEST_CASE("measure", "[]") {
+	char buffer[200];
+
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%d|%-8u|%#10x|%+.5lld", -123, 42U, 0xabcU, 77LL) == 31);
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, 0U, "%p %s %5c", (void*)buffer, "abc", 'x') == (int)(sizeof(void*) * 2U) + 10);
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%.3f|%012.1f|%e|%g", 3.14159, -2.5, 1e300, 0.0001) == 39);
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%.0f", 1e308) == 309);
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%.1f", 9.96) == 4);
+
+	// the same length as the formatted output
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%#o %b %X %.0x", 8U, 5U, 0xFFFFFFFFU, 0U) == mpaland_dbjdbj::sprintf(buffer, "%#o %b %X %.0x", 8U, 5U, 0xFFFFFFFFU, 0U));
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%-40llu|", 18446744073709551615ULL) == mpaland_dbjdbj::sprintf(buffer, "%-40llu|", 18446744073709551615ULL));
+}
+
+
+// a container which cannot grow past its limit
+struct limited_string : std::string {
+	size_t limit;
+	void resize(size_t size)
+	{
+		if (size > limit) {
+			throw std::bad_alloc();
+		}
+		std::string::resize(size);
+	}
+};
+
+static int call_format_to(limited_string* out, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	const int ret = mpaland_dbjdbj::inner::_vformat_to(out, format, args);
+	va_end(args);
+	return ret;
+}
+
+
+TEST_CASE("format_to", "[]") {
+	std::string text = "n=";
+	REQUIRE(mpaland_dbjdbj::format_to(text, "%d, %s", 42, "abc") == 7);
+	REQUIRE(text == "n=42, abc");
+
+	// beyond the stage, grown in place
+	REQUIRE(mpaland_dbjdbj::format_to(text, "|%1000d|%x", 7, 255U) == 1004);
+	REQUIRE(text.size() == 1013U);
+	REQUIRE(text.compare(0U, 10U, "n=42, abc|") == 0);
+	REQUIRE(text.compare(1007U, 6U, "  7|ff") == 0);
+
+	std::vector<char> bytes;
+	REQUIRE(mpaland_dbjdbj::format_to(bytes, "%c%c%.2f", 'a', 'b', 1.5) == 6);
+	REQUIRE(std::string(bytes.begin(), bytes.end()) == "ab1.50");
+
+	REQUIRE(mpaland_dbjdbj::format_to(text, PRINTF_FMT("%u"), 5U) == 1);
+	REQUIRE(text.back() == '5');
+
+	char* p = nullptr;
+	REQUIRE(mpaland_dbjdbj::asprintf(&p, "%s-%05d", "id", 12) == 8);
+	REQUIRE(!strcmp(p, "id-00012"));
+	free(p);
+	REQUIRE(mpaland_dbjdbj::asprintf(&p, "%300s", "x") == 300);
+	REQUIRE(strlen(p) == 300U);
+	REQUIRE(p[299] == 'x');
+	free(p);
+
+	// the allocation failure is returned, and the container left as it was
+	limited_string limited;
+	limited.assign("kept");
+	limited.limit = 600U;
+	REQUIRE(call_format_to(&limited, "%500d", 1) == 500);
+	REQUIRE(limited.size() == 504U);
+	REQUIRE(call_format_to(&limited, "%100d", 2) == -1);
+	REQUIRE(limited.size() == 504U);
+	REQUIRE(call_format_to(&limited, "%1000d", 3) == -1);
+	REQUIRE(limited.size() == 504U);
+}
+
+
+#if defined(PRINTF_SUPPORT_FORMAT_ARENA)
+TEST_CASE("format arena", "[]") {
+	char storage[32];
+	mpaland_dbjdbj::format_arena_type arena;
+
+	// the caller's buffer only
+	mpaland_dbjdbj::arena_init(&arena, storage, sizeof(storage));
+	const std::string_view first = mpaland_dbjdbj::arena_printf(&arena, "%s=%d", "a", 1);
+	const std::string_view second = mpaland_dbjdbj::arena_printf(&arena, "%05u", 42U);
+	REQUIRE(first == "a=1");
+	REQUIRE(second == "00042");
+	REQUIRE(second.data() == storage + 4);
+	REQUIRE(mpaland_dbjdbj::arena_printf(&arena, "%30s", "x").empty());
+	REQUIRE(arena.stats.strings == 2U);
+	REQUIRE(arena.stats.bytes == 8U);
+	REQUIRE(arena.stats.failures == 1U);
+
+	// growing from a memory resource, the strings stay where they are
+	char pool[16384];
+	std::pmr::monotonic_buffer_resource resource(pool, sizeof(pool), std::pmr::null_memory_resource());
+	mpaland_dbjdbj::arena_init(&arena, storage, sizeof(storage), &resource);
+	std::string_view views[40];
+	for (unsigned int i = 0U; i < 40U; i++) {
+		views[i] = mpaland_dbjdbj::arena_printf(&arena, "string %u of %-100s|", i, "forty");
+	}
+	for (unsigned int i = 0U; i < 40U; i++) {
+		char expected[200];
+		mpaland_dbjdbj::sprintf(expected, "string %u of %-100s|", i, "forty");
+		REQUIRE(views[i] == expected);
+		REQUIRE(views[i].data()[views[i].size()] == '\0');
+	}
+	REQUIRE(mpaland_dbjdbj::arena_printf(&arena, "%5000d", 1).size() == 5000U);
+	REQUIRE(arena.stats.strings == 41U);
+	REQUIRE(arena.stats.blocks == 3U);
+	REQUIRE(arena.stats.refills == 3U);
+
+	mpaland_dbjdbj::arena_release(&arena);
+	REQUIRE(mpaland_dbjdbj::arena_printf(&arena, "%d", 7).data() == storage);
+}
+#endif  // PRINTF_SUPPORT_FORMAT_ARENA
+
+
+static void _block_sink(const char* data, size_t len, void* arg)
+{
+	std::vector<std::string>* blocks = (std::vector<std::string>*)arg;
+	blocks->emplace_back(data, len);
+}
+
+
+TEST_CASE("fctprintf_block", "[]") {
+	std::vector<std::string> blocks;
+
+	// one call for a short output, without the terminating 0
+	REQUIRE(mpaland_dbjdbj::fctprintf_block(_block_sink, &blocks, "%s=%d, %c", "key", 42, 'z') == 9);
+	REQUIRE(blocks.size() == 1U);
+	REQUIRE(blocks[0] == "key=42, z");
+
+	// longer output in full stages
+	blocks.clear();
+	REQUIRE(mpaland_dbjdbj::fctprintf_block(_block_sink, &blocks, "%100d%100d%s", 1, 2, "end") == 203);
+	std::string all;
+	for (const std::string& block : blocks) {
+		REQUIRE(block.size() <= mpaland_dbjdbj::inner::PRINTF_FCT_BUFFER_SIZE);
+		all += block;
+	}
+	REQUIRE(blocks.size() == 2U);
+	REQUIRE(all.size() == 203U);
+	REQUIRE(all.compare(200U, 3U, "end") == 0);
+
+	blocks.clear();
+	REQUIRE(mpaland_dbjdbj::fctprintf_block(_block_sink, &blocks, PRINTF_FMT("%x"), 255U) == 2);
+	REQUIRE(blocks.size() == 1U);
+	REQUIRE(blocks[0] == "ff");
+}
+
+
+TEST_CASE("output sinks", "[]") {
+	// every output the engine is instantiated for writes the same characters
+	auto check = [](const char* format, auto... args) {
+		char expected[100];
+		const int len = mpaland_dbjdbj::snprintf(expected, sizeof(expected), format, args...);
+		REQUIRE(len >= 0);
+		REQUIRE(len < 90);
+
+		// null, only measuring
+		REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, format, args...) == len);
+
+		// _putchar
+		test::reset_buffering();
+		REQUIRE(mpaland_dbjdbj::printf(format, args...) == len);
+		REQUIRE(!strcmp(test::printf_buffer, expected));
+
+		// character function
+		test::reset_buffering();
+		REQUIRE(mpaland_dbjdbj::fctprintf(&_out_fct, nullptr, format, args...) == len);
+		REQUIRE(!strcmp(test::printf_buffer, expected));
+
+		// block function
+		std::vector<std::string> blocks;
+		REQUIRE(mpaland_dbjdbj::fctprintf_block(_block_sink, &blocks, format, args...) == len);
+		std::string all;
+		for (const std::string& block : blocks) {
+			all += block;
+		}
+		REQUIRE(all == expected);
+
+		// growable container
+		std::string text;
+		REQUIRE(mpaland_dbjdbj::format_to(text, format, args...) == len);
+		REQUIRE(text == expected);
+
+		// callable, with the typed arguments
+		std::string called;
+		REQUIRE(mpaland_dbjdbj::format([&called](const char* data, std::size_t size) { called.append(data, size); }, format, args...) == len);
+		REQUIRE(called == expected);
+	};
+	check("%d|%5u|%-8x|%#o|%+.12d", -123456789, 42U, 255U, 8U, 7);
+	check("%lld %#llX %b", -9223372036854775807LL - 1, 18446744073709551615ULL, 5U);
+	check("%p %c %% %5c", (void*)0x1234, 'a', 'b');
+	check("%.3s|%10.2s|%-6s|", "abcdef", "xyz", "tail");
+	check("%f|%.2e|%g|%12.4G", -3.25, 12345.678, 0.0001234, 1e20);
+	check("%a %.3A %.0f", 1.0, -0.1, 1e15);
+	check("only a literal");
+}
+
+
+#if defined(PRINTF_SUPPORT_LOG_RING)
+static std::string _log_file_read(FILE* file)
+{
+	std::string text;
+	char buffer[4096];
+	std::rewind(file);
+	for (size_t n; (n = std::fread(buffer, 1U, sizeof(buffer), file)) != 0U; ) {
+		text.append(buffer, n);
+	}
+	return text;
+}
+
+
+TEST_CASE("log ring", "[]") {
+	using namespace mpaland_dbjdbj;
+	static log_ring_type ring;
+
+	SECTION("drop") {
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 4U, LOG_POLICY_DROP, false));
+		for (int i = 0; i < 6; ++i) {
+			REQUIRE(log_printf(&ring, "line %d\n", i) == (i < 4 ? 7 : -1));
+		}
+		REQUIRE(log_drain(&ring) == 4U);
+		REQUIRE(log_printf(&ring, "%300s", "x") == 300);
+		log_stop(&ring);
+		const log_stats_type stats = log_stats(&ring);
+		REQUIRE(stats.messages == 5U);
+		REQUIRE(stats.drops == 2U);
+		REQUIRE(stats.truncated == 1U);
+		REQUIRE(stats.high_water == 4U);
+		REQUIRE(stats.writes == 2U);
+		REQUIRE(stats.bytes == 28U + inner::PRINTF_LOG_SLOT_SIZE - 1U);
+		REQUIRE(_log_file_read(file).compare(0U, 28U, "line 0\nline 1\nline 2\nline 3\n") == 0);
+		std::fclose(file);
+	}
+
+	SECTION("overwrite") {
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 4U, LOG_POLICY_OVERWRITE, false));
+		for (int i = 0; i < 6; ++i) {
+			REQUIRE(log_printf(&ring, "line %d\n", i) == 7);
+		}
+		log_stop(&ring);
+		REQUIRE(log_stats(&ring).overwrites == 2U);
+		REQUIRE(_log_file_read(file) == "line 2\nline 3\nline 4\nline 5\n");
+		std::fclose(file);
+	}
+
+	SECTION("deferred") {
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 8U, LOG_POLICY_DROP, false));
+		char name[16];
+		std::strcpy(name, "first");
+		REQUIRE(log_defer(&ring, "%s: %d %x %.3f|", name, -42, 255U, 2.5) == 0);
+		// the string was copied
+		std::strcpy(name, "second");
+		REQUIRE(log_defer(&ring, PRINTF_FMT("%*s|%c|"), 8, std::string_view(name, 3), 'z') == 0);
+		REQUIRE(log_defer(&ring, "%d items|", "not a number") == 0);
+		const std::string long_string(300U, 'x');
+		REQUIRE(log_defer(&ring, "%s", long_string.c_str()) == 0);
+		log_stop(&ring);
+		const log_stats_type stats = log_stats(&ring);
+		REQUIRE(stats.messages == 4U);
+		REQUIRE(stats.invalid == 1U);
+		REQUIRE(stats.truncated == 1U);
+		const std::string text = _log_file_read(file);
+		REQUIRE(text.compare(0U, 43U, "first: -42 ff 2.500|     sec|z|xxxxxxxxxxxx") == 0);
+		REQUIRE(text.size() < 31U + inner::PRINTF_LOG_SLOT_SIZE);
+		std::fclose(file);
+	}
+
+	SECTION("deferred null string") {
+		const char* none = nullptr;
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 8U, LOG_POLICY_DROP, false));
+		REQUIRE(log_defer(&ring, "%s|%5s|", none, none) == 0);
+		REQUIRE(log_defer(&ring, PRINTF_FMT("%s|%.2s|"), none, "abc") == 0);
+		log_stop(&ring);
+		REQUIRE(log_stats(&ring).invalid == 0U);
+		REQUIRE(_log_file_read(file) == "(null)|(null)|(null)|ab|");
+		std::fclose(file);
+
+		// and in a binary log
+		file = std::tmpfile();
+		REQUIRE(log_start_binary(&ring, fileno(file), 8U, LOG_POLICY_DROP, false));
+		REQUIRE(log_defer(&ring, "%s|%s|", "one", none) == 0);
+		log_stop(&ring);
+		const std::string data = _log_file_read(file);
+		std::fclose(file);
+		auto append = [](const char* text, size_t len, void* arg) { ((std::string*)arg)->append(text, len); };
+		log_decoder_type decoder{};
+		std::string text;
+		REQUIRE(log_decode(&decoder, data.data(), data.size(), append, &text) == (ptrdiff_t)data.size());
+		REQUIRE(text == "one|(null)|");
+
+		// a char pointer has no address to write once it is copied, a PRINTF_FMT format does not compile
+		auto pointer = PRINTF_FMT("%p");
+		using pointer_format = decltype(pointer);
+		static_assert(!inner::_args_match<pointer_format, char*>(true), "a copied char pointer for %p");
+		static_assert(inner::_args_match<pointer_format, void*>(true), "a void pointer for %p");
+		static_assert(inner::_args_match<pointer_format, char*>(), "a char pointer for %p of format()");
+		file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 8U, LOG_POLICY_DROP, false));
+		REQUIRE(log_defer(&ring, pointer, (void*)file) == 0);
+		log_stop(&ring);
+		REQUIRE(_log_file_read(file).size() == 2U * sizeof(void*));
+		std::fclose(file);
+	}
+
+	SECTION("binary") {
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start_binary(&ring, fileno(file), 16U, LOG_POLICY_DROP, false));
+		const char* format = "%s %d %u %x|";
+		REQUIRE(log_defer(&ring, format, "one", (signed char)-5, (unsigned short)65535U, -1LL) == 0);
+		REQUIRE(log_defer(&ring, format, std::string_view("two"), -70000, 7U, (short)-2) == 0);
+		REQUIRE(log_printf(&ring, "text %d|", 3) == 7);
+		REQUIRE(log_defer(&ring, PRINTF_FMT("%.2f %c %p|"), -1.25, 'q', (void*)0x1234) == 0);
+		log_stop(&ring);
+		const std::string data = _log_file_read(file);
+		std::fclose(file);
+
+		const std::string expected = "one -5 65535 ffffffffffffffff|two -70000 7 fffe|text 3|-1.25 q 0000000000001234|";
+		auto append = [](const char* text, size_t len, void* arg) { ((std::string*)arg)->append(text, len); };
+		log_decoder_type decoder{};
+		std::string text;
+		REQUIRE(log_decode(&decoder, data.data(), data.size(), append, &text) == (ptrdiff_t)data.size());
+		REQUIRE(text.compare(0U, 49U, expected, 0U, 49U) == 0);
+		REQUIRE(text.size() == expected.size() + 2U * sizeof(void*) - 16U);
+
+		// in pieces, an entry cut in two is taken up by the next call
+		log_decoder_type pieces{};
+		std::string text2;
+		size_t done = 0U;
+		for (size_t end = 1U; end <= data.size(); ++end) {
+			const ptrdiff_t ret = log_decode(&pieces, data.data() + done, end - done, append, &text2);
+			REQUIRE(ret >= 0);
+			done += (size_t)ret;
+		}
+		REQUIRE(done == data.size());
+		REQUIRE(text2 == text);
+
+		log_decoder_type other{};
+		REQUIRE(log_decode(&other, expected.data(), expected.size(), append, &text) == -1);
+
+		// a record whose argument does not suit its format is not rendered, the text before it is
+		auto entry = [](std::string& out, char kind, uint16_t value, const char* text, size_t len) {
+			out += kind;
+			out.append((const char*)&value, sizeof(value));
+			if (kind == 'F') {
+				const uint16_t length = (uint16_t)len;
+				out.append((const char*)&length, sizeof(length));
+			}
+			out.append(text, len);
+		};
+		std::string bad = data.substr(0U, sizeof(log_file_header_type));
+		entry(bad, 'T', 6U, "before", 6U);
+		entry(bad, 'F', 0U, "%d|", 3U);
+		const uint16_t length = 3U;
+		entry(bad, 'R', 0U, "\x01", 1U);
+		bad += (char)inner::ARG_STRING;
+		bad.append((const char*)&length, sizeof(length));
+		bad += "abc";
+		entry(bad, 'T', 5U, "after", 5U);
+		log_decoder_type mismatched{};
+		std::string text3;
+		REQUIRE(log_decode(&mismatched, bad.data(), bad.size(), append, &text3) == -1);
+		REQUIRE(text3 == "before");
+
+		// a record of an id no 'F' entry gave, below one which was given
+		std::string forged = data.substr(0U, sizeof(log_file_header_type));
+		entry(forged, 'F', 2U, "x|", 2U);
+		entry(forged, 'R', 2U, "\x00", 1U);
+		entry(forged, 'R', 1U, "\x00", 1U);
+		log_decoder_type gaps{};
+		std::string text4;
+		REQUIRE(log_decode(&gaps, forged.data(), forged.size(), append, &text4) == -1);
+		REQUIRE(text4 == "x|");
+	}
+
+	SECTION("threads") {
+		FILE* file = std::tmpfile();
+		REQUIRE(log_start(&ring, fileno(file), 64U, LOG_POLICY_BLOCK));
+		std::vector<std::thread> producers;
+		for (int t = 0; t < 4; ++t) {
+			producers.emplace_back([t] {
+				for (int i = 0; i < 1000; ++i) {
+					log_printf(&ring, "%d:%04d\n", t, i);
+				}
+			});
+		}
+		for (std::thread& producer : producers) {
+			producer.join();
+		}
+		log_stop(&ring);
+		const std::string text = _log_file_read(file);
+		REQUIRE(text.size() == 4U * 1000U * 7U);
+		REQUIRE(log_stats(&ring).bytes == text.size());
+		// each producer's lines come out in its order
+		for (int t = 0; t < 4; ++t) {
+			int next = 0;
+			for (size_t i = 0U; i < text.size(); i += 7U) {
+				if (text[i] == '0' + t) {
+					REQUIRE(std::atoi(text.c_str() + i + 2U) == next++);
+				}
+			}
+			REQUIRE(next == 1000);
+		}
+		std::fclose(file);
+	}
+}
+#endif  // PRINTF_SUPPORT_LOG_RING
+
+
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+TEST_CASE("format stats", "[]") {
+	using mpaland_dbjdbj::format_stats_type;
+	char buffer[8];
+	const format_stats_type before = mpaland_dbjdbj::format_stats();
+
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), "%d %-5x", 12, 255U) == 8);
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), PRINTF_FMT("%+.2f"), 1.5) == 5);
+	REQUIRE(mpaland_dbjdbj::snprintf(nullptr, 0U, "%s", "measured only") == 13);
+	// counted on another thread, which is gone when the counters are added up
+	std::thread([] {
+		char out[4];
+		mpaland_dbjdbj::format(out, "%#o", 8);
+	}).join();
+
+	const format_stats_type after = mpaland_dbjdbj::format_stats();
+	REQUIRE(after.calls - before.calls == 4U);
+	REQUIRE(after.bytes - before.bytes == 8U + 5U + 13U + 3U);
+	REQUIRE(after.truncated - before.truncated == 1U);
+	REQUIRE(after.specifiers['d'] - before.specifiers['d'] == 1U);
+	REQUIRE(after.specifiers['x'] - before.specifiers['x'] == 1U);
+	REQUIRE(after.specifiers['f'] - before.specifiers['f'] == 1U);
+	REQUIRE(after.specifiers['s'] - before.specifiers['s'] == 1U);
+	REQUIRE(after.specifiers['o'] - before.specifiers['o'] == 1U);
+	REQUIRE(after.flags[0] - before.flags[0] == 2U);           // %d and %s
+	REQUIRE(after.flags[2U | 32U] - before.flags[2U | 32U] == 1U);    // - and a width
+	REQUIRE(after.flags[4U | 64U] - before.flags[4U | 64U] == 1U);    // + and a precision
+	REQUIRE(after.flags[16U] - before.flags[16U] == 1U);       // #
+}
+#else
+TEST_CASE("format stats", "[]") {
+	char buffer[8];
+	REQUIRE(mpaland_dbjdbj::snprintf(buffer, sizeof(buffer), "%d", 12) == 2);
+	// the counting is compiled out
+	const mpaland_dbjdbj::format_stats_type stats = mpaland_dbjdbj::format_stats();
+	REQUIRE(stats.calls == 0U);
+	REQUIRE(stats.bytes == 0U);
+	REQUIRE(stats.specifiers['d'] == 0U);
+}
+#endif  // PRINTF_SUPPORT_INSTRUMENTATION
+
+
+TEST_CASE("field bounds", "[]") {
+	// the fields end before, at and past the end of the buffer, the rest of it is not touched
+	auto check = [](const char* format, auto... args) {
+		char full[600];
+		char buffer[600];
+		const int len = mpaland_dbjdbj::snprintf(full, sizeof(full), format, args...);
+		REQUIRE(len > 0);
+		REQUIRE(len < 500);
+		for (size_t n = 0U; n <= (size_t)len + 2U; n++) {
+			memset(buffer, 'z', sizeof(buffer));
+			REQUIRE(mpaland_dbjdbj::snprintf(buffer + 1, n, format, args...) == len);
+			REQUIRE(buffer[0] == 'z');
+			if (n) {
+				const size_t written = n - 1U < (size_t)len ? n - 1U : (size_t)len;
+				REQUIRE(!memcmp(buffer + 1, full, written));
+				REQUIRE(buffer[1U + written] == '\0');
+			}
+			const std::string rest(buffer + 1U + n, sizeof(buffer) - 1U - n);
+			REQUIRE(rest.find_first_not_of('z') == std::string::npos);
+		}
+	};
+	check("%d|%5u|%-8x|%#o|%+.12d", -123456789, 42U, 255U, 8U, 7);
+	check("[%#b][%030d][%.31x]", 1023U, -5, 1U);
+	check("%lld %llu %#llX", -9223372036854775807LL - 1, 18446744073709551615ULL, 18446744073709551615ULL);
+	check("%p %c %% %5c %y", (void*)0x1234, 'a', 'b');
+	check("%.3s|%10.2s|%s", "abcdef", "xyz", "tail");
+	check("%f|%.2e|%g|%12.4G", -3.25, 12345.678, 0.0001234, 1e20);
+	check("%.0f %e %a %.3A", 1e300, -1e-300, 1.0, -0.1);
+}
+
+
+TEST_CASE("snprintf_trunc", "[]") {
+	using mpaland_dbjdbj::snprintf_trunc_type;
+	char buffer[8];
+
+	snprintf_trunc_type ret = mpaland_dbjdbj::snprintf_trunc(buffer, sizeof(buffer), "%d|%s", 42, "ab");
+	REQUIRE(ret.written == 5U);
+	REQUIRE(!ret.truncated);
+	REQUIRE(!strcmp(buffer, "42|ab"));
+
+	// exactly full
+	ret = mpaland_dbjdbj::snprintf_trunc(buffer, sizeof(buffer), "%7s", "x");
+	REQUIRE(ret.written == 7U);
+	REQUIRE(!ret.truncated);
+	REQUIRE(!strcmp(buffer, "      x"));
+
+	// the conversions after the first one which does not fit are not done
+	const mpaland_dbjdbj::format_stats_type before = mpaland_dbjdbj::format_stats();
+	ret = mpaland_dbjdbj::snprintf_trunc(buffer, sizeof(buffer), "%s %x %x", "a long column", 1U, 2U);
+	REQUIRE(ret.written == 7U);
+	REQUIRE(ret.truncated);
+	REQUIRE(!strcmp(buffer, "a long "));
+#if defined(PRINTF_SUPPORT_INSTRUMENTATION)
+	REQUIRE(mpaland_dbjdbj::format_stats().specifiers['x'] == before.specifiers['x']);
+#else
+	(void)before;
+#endif
+
+	ret = mpaland_dbjdbj::snprintf_trunc(buffer, 0U, "%d", 1);
+	REQUIRE(ret.written == 0U);
+	REQUIRE(ret.truncated);
+	ret = mpaland_dbjdbj::snprintf_trunc(nullptr, 0U, "");
+	REQUIRE(ret.written == 0U);
+	REQUIRE(!ret.truncated);
+	ret = mpaland_dbjdbj::snprintf_trunc(nullptr, sizeof(buffer), "%d", 1);
+	REQUIRE(ret.written == 0U);
+	REQUIRE(ret.truncated);
+	ret = mpaland_dbjdbj::snprintf_trunc(nullptr, sizeof(buffer), "%s", "");
+	REQUIRE(ret.written == 0U);
+	REQUIRE(!ret.truncated);
+}
+
+
 } // namespace
 
 ///////////////////////////////////////////////////////////////////////////////
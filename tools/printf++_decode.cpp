@@ -0,0 +1,65 @@
+// license at eof
+// renders a binary log of log_start_binary() back to text, with the printf++ engine
+//   printf++_decode [file]     the log is read from stdin without a file
+// build e.g.
+//   g++ -std=c++17 -O2 tools/printf++_decode.cpp -o printf++_decode -lpthread
+#define PRINTF_SUPPORT_LOG_RING
+#include "../printf++.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+	void _out_stdout(const char* data, size_t len, void* arg)
+	{
+		std::fwrite(data, 1U, len, (FILE*)arg);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	FILE* in = argc > 1 ? std::fopen(argv[1], "rb") : stdin;
+	if (!in) {
+		std::fprintf(stderr, "printf++_decode: cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	mpaland_dbjdbj::log_decoder_type decoder{};
+	std::vector<char> data(1U << 16U);
+	size_t len = 0U;
+	for (;;) {
+		const size_t n = std::fread(data.data() + len, 1U, data.size() - len, in);
+		len += n;
+		const ptrdiff_t done = mpaland_dbjdbj::log_decode(&decoder, data.data(), len, _out_stdout, stdout);
+		if (done < 0) {
+			std::fprintf(stderr, "printf++_decode: not a binary log of this version and byte order, or a record does not suit its format\n");
+			return 1;
+		}
+		// the rest of an entry cut in two goes first
+		len -= (size_t)done;
+		std::memmove(data.data(), data.data() + done, len);
+		if (!n) {
+			break;
+		}
+		if (len == data.size()) {
+			data.resize(data.size() * 2U);
+		}
+	}
+	if (in != stdin) {
+		std::fclose(in);
+	}
+	if (len) {
+		std::fprintf(stderr, "printf++_decode: the log ends inside an entry\n");
+		return 1;
+	}
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// \author (c) C VERSION -- Marco Paland (info@paland.com)
+//             2014-2018, PALANDesign Hannover, Germany
+//         (c) CPP HEADER ONLY VERSION -- Dusan B. Jovanovic ( dbj@dbj.org )
+//             2018, dbj.systems, London, UK 
+//
+// \license The MIT License (MIT)
+///////////////////////////////////////////////////////////////////////////////